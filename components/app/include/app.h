@@ -16,6 +16,10 @@ typedef struct {
     display_handles_t* display;
     /**< Backlight handle used by the application for runtime control. */
     backlight_handle_t* backlight;
+    /**< Optional hook that applies the latest data to the UI on wake and ambient updates. */
+    void (*on_display_refresh)(void);
+    /**< Optional hook that stores resume state in RTC memory before deep sleep. */
+    void (*on_deep_sleep)(void);
 } app_config_t;
 
 /**
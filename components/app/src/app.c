@@ -1,12 +1,13 @@
 #include "app.h"
+#include "deferred_log.h"
 #include "esp_log.h"
 #include "esp_lvgl_port.h"
 #include "esp_timer.h"
 #include "ui.h"
 #include "power_manager.h"
+#include "settings.h"
 
 static const char* TAG = "app";
-static const int64_t APP_IDLE_TIMEOUT_US = 60LL * 1000000LL;
 static const uint8_t APP_BRIGHTNESS_STEP_PCT = 5U;
 static const uint8_t APP_BRIGHTNESS_MIN_PCT = 5U;
 
@@ -54,8 +55,10 @@ void app_init(const app_config_t* config)
     app_cfg = *config;
 
     power_manager_config_t pm_cfg = {
-        .panel_handle = config->display->panel_handle,
+        .display = config->display,
         .bl_handle = config->backlight,
+        .on_display_refresh = config->on_display_refresh,
+        .on_deep_sleep = config->on_deep_sleep,
     };
     power_manager_init(&pm_cfg);
 
@@ -70,16 +73,16 @@ void app_on_button_short_press(button_id_t btn_id)
         return;
     }
 
-    if (power_manager_is_monitoring()) {
-        ESP_LOGI(TAG, "Wake display from monitoring mode");
-        power_manager_exit_monitoring();
+    if (power_manager_get_idle_stage() != POWER_IDLE_STAGE_ACTIVE) {
+        DLOG_I(TAG, "Wake display from idle");
+        power_manager_wake_from_idle();
         app_mark_activity();
         lvgl_port_unlock();
         return;
     }
 
     if (btn_id == ignore_next_short_for) {
-        ESP_LOGI(TAG, "Ignoring short press on release after long press");
+        DLOG_I(TAG, "Ignoring short press on release after long press");
         ignore_next_short_for = BTN_ID_NONE;
         lvgl_port_unlock();
         return;
@@ -101,9 +104,9 @@ void app_on_button_short_press(button_id_t btn_id)
         esp_err_t ret = power_manager_set_active_brightness(clamped, true);
         if (ret == ESP_OK) {
             ui_update_brightness_value(clamped);
-            ESP_LOGI(TAG, "Brightness set to %u%%", (unsigned int)clamped);
+            DLOG_I(TAG, "Brightness set to %u%%", (unsigned int)clamped);
         } else {
-            ESP_LOGW(TAG, "Failed to set brightness: %s", esp_err_to_name(ret));
+            DLOG_W(TAG, "Failed to set brightness: %s", esp_err_to_name(ret));
         }
 
         app_mark_activity();
@@ -113,14 +116,14 @@ void app_on_button_short_press(button_id_t btn_id)
 
     if (current == SCREEN_ID_QUESTION) {
         if (btn_id == question_activated_by) {
-            ESP_LOGI(TAG, "Question confirmed");
+            DLOG_I(TAG, "Question confirmed");
             question_activated_by = BTN_ID_NONE;
             app_mark_activity();
             lvgl_port_unlock();
             ui_question_confirm();
             return;
         } else {
-            ESP_LOGI(TAG, "Question selection changed");
+            DLOG_I(TAG, "Question selection changed");
             if (btn_id == BTN_ID_PREV) {
                 ui_question_select_yes();
                 question_activated_by = BTN_ID_PREV;
@@ -131,10 +134,10 @@ void app_on_button_short_press(button_id_t btn_id)
         }
     } else {
         if (btn_id == BTN_ID_PREV) {
-            ESP_LOGI(TAG, "Switch to prev screen");
+            DLOG_I(TAG, "Switch to prev screen");
             ui_switch_prev();
         } else {
-            ESP_LOGI(TAG, "Switch to next screen");
+            DLOG_I(TAG, "Switch to next screen");
             ui_switch_next();
         }
     }
@@ -150,9 +153,9 @@ void app_on_button_long_press(button_id_t btn_id)
         return;
     }
 
-    if (power_manager_is_monitoring()) {
-        ESP_LOGI(TAG, "Wake display from monitoring mode (long press)");
-        power_manager_exit_monitoring();
+    if (power_manager_get_idle_stage() != POWER_IDLE_STAGE_ACTIVE) {
+        DLOG_I(TAG, "Wake display from idle (long press)");
+        power_manager_wake_from_idle();
         app_mark_activity();
         lvgl_port_unlock();
         return;
@@ -166,19 +169,24 @@ void app_on_button_long_press(button_id_t btn_id)
     }
 
     if (current == SCREEN_ID_BRIGHTNESS) {
-        if (btn_id == BTN_ID_NEXT) {
-            ESP_LOGI(TAG, "Close brightness setup");
+        bool closed = (btn_id == BTN_ID_NEXT);
+        if (closed) {
+            DLOG_I(TAG, "Close brightness setup");
             ui_hide_special();
             app_mark_activity();
         }
         ignore_next_short_for = btn_id;
         lvgl_port_unlock();
+        if (closed) {
+            /* Brightness steps were only cached; write the final level once, outside the LVGL lock. */
+            settings_flush();
+        }
         return;
     }
 
     if (btn_id == BTN_ID_NEXT) {
         uint8_t brightness = power_manager_get_active_brightness();
-        ESP_LOGI(TAG, "Open brightness setup (%u%%)", (unsigned int)brightness);
+        DLOG_I(TAG, "Open brightness setup (%u%%)", (unsigned int)brightness);
         ui_show_brightness(brightness);
         ignore_next_short_for = BTN_ID_NEXT;
         app_mark_activity();
@@ -186,7 +194,7 @@ void app_on_button_long_press(button_id_t btn_id)
         return;
     }
 
-    ESP_LOGI(TAG, "Long press - showing shutdown question");
+    DLOG_I(TAG, "Long press - showing shutdown question");
 
     question_activated_by = btn_id;
     ignore_next_short_for = btn_id;
@@ -199,18 +207,10 @@ void app_on_button_long_press(button_id_t btn_id)
 
 void app_process_idle(void)
 {
-    if (power_manager_is_monitoring()) {
-        return;
-    }
-
     if (last_activity_time_us == 0) {
         app_mark_activity();
         return;
     }
 
-    int64_t now = esp_timer_get_time();
-    if ((now - last_activity_time_us) >= APP_IDLE_TIMEOUT_US) {
-        ESP_LOGI(TAG, "Idle timeout reached -> monitoring mode");
-        power_manager_enter_monitoring();
-    }
+    power_manager_process_idle(esp_timer_get_time() - last_activity_time_us);
 }
@@ -29,7 +29,7 @@ typedef struct {
 } backlight_handle_t;
 
 /**
- * @brief Initialize the backlight controller
+ * @brief Initialize the backlight controller and the LEDC fade engine
  *
  * @param[in] config Pointer to the backlight configuration structure
  * @param[out] handle Pointer to the backlight handle structure
@@ -42,6 +42,9 @@ esp_err_t backlight_init(const backlight_config_t* config, backlight_handle_t* h
 /**
  * @brief Set the backlight brightness
  *
+ * The percent is perceptual: it maps through a CIE 1931 lightness table onto
+ * the LEDC duty, so equal steps look equally large.
+ *
  * @param[in] handle Pointer to the initialized backlight handle
  * @param[in] brightness_percent Brightness level in percent (0-100)
  * @return
@@ -50,6 +53,34 @@ esp_err_t backlight_init(const backlight_config_t* config, backlight_handle_t* h
  */
 esp_err_t backlight_set_brightness(const backlight_handle_t* handle, uint8_t brightness_percent);
 
+/**
+ * @brief Fade the backlight to a brightness level in hardware
+ *
+ * Returns immediately; the LEDC fade engine steps the duty without CPU
+ * involvement. A fade in progress is stopped and the new one starts from the
+ * current duty. A zero fade time sets the level at once. The percent is
+ * perceptual, as in backlight_set_brightness().
+ *
+ * @param[in] handle Pointer to the initialized backlight handle
+ * @param[in] brightness_percent Target brightness level in percent (0-100)
+ * @param[in] fade_ms Fade duration in milliseconds
+ * @return
+ *         - ESP_ERR_INVALID_ARG if parameter is invalid
+ *         - ESP_OK on success
+ *         - Other LEDC driver errors if the fade could not be started
+ */
+esp_err_t backlight_fade_to(const backlight_handle_t* handle, uint8_t brightness_percent, uint32_t fade_ms);
+
+/**
+ * @brief Get the duty currently driven on the backlight channel
+ *
+ * Reflects a fade in progress. Compare against handle->duty for the on-time share.
+ *
+ * @param[in] handle Pointer to the initialized backlight handle
+ * @return Current LEDC duty, 0 if @p handle is NULL
+ */
+uint32_t backlight_get_duty(const backlight_handle_t* handle);
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
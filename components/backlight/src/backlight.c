@@ -8,6 +8,30 @@
 
 static const char* TAG = "backlight";
 
+/* CIE 1931 lightness: percent -> relative luminance, 0..65535. */
+static const uint16_t gamma_lut[101] = {
+    0, 73, 145, 218, 290, 363, 435, 508, 580, 656,
+    738, 826, 922, 1024, 1134, 1251, 1376, 1509, 1650, 1800,
+    1959, 2127, 2304, 2491, 2687, 2894, 3111, 3338, 3576, 3826,
+    4087, 4359, 4643, 4940, 5248, 5569, 5903, 6251, 6611, 6985,
+    7373, 7775, 8192, 8623, 9069, 9530, 10006, 10498, 11006, 11530,
+    12071, 12628, 13202, 13793, 14401, 15027, 15671, 16333, 17014, 17713,
+    18431, 19168, 19924, 20700, 21497, 22313, 23149, 24007, 24885, 25784,
+    26705, 27648, 28612, 29598, 30607, 31639, 32694, 33771, 34872, 35997,
+    37146, 38319, 39516, 40738, 41986, 43258, 44555, 45879, 47228, 48603,
+    50005, 51434, 52890, 54372, 55883, 57421, 58987, 60581, 62203, 63855,
+    65535,
+};
+
+static uint32_t backlight_percent_to_duty(const backlight_handle_t* handle, uint8_t brightness_percent)
+{
+    uint32_t duty = ((uint32_t)gamma_lut[brightness_percent] * handle->duty + 32767U) / 65535U;
+    if (brightness_percent > 0 && duty == 0) {
+        duty = 1;
+    }
+    return duty;
+}
+
 esp_err_t backlight_init(const backlight_config_t* config, backlight_handle_t* handle)
 {
     if (!config || !handle) {
@@ -40,6 +64,12 @@ esp_err_t backlight_init(const backlight_config_t* config, backlight_handle_t* h
     ESP_ERROR_CHECK(ledc_channel_config(&channel_config));
     ESP_ERROR_CHECK(ledc_timer_config(&timer_config));
 
+    esp_err_t ret = ledc_fade_func_install(0);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "Failed to install LEDC fade: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
     handle->channel = config->leds_channel;
     handle->leds_mode = config->leds_mode;
     handle->duty = (1 << config->duty_resolution) - 1;
@@ -59,9 +89,51 @@ esp_err_t backlight_set_brightness(const backlight_handle_t* handle, uint8_t bri
         return ESP_ERR_INVALID_ARG;
     }
 
-    uint32_t duty = (brightness_percent * handle->duty) / 100;
-    ESP_ERROR_CHECK(ledc_set_duty(handle->leds_mode, handle->channel, duty));
-    ESP_ERROR_CHECK(ledc_update_duty(handle->leds_mode, handle->channel));
+    uint32_t duty = backlight_percent_to_duty(handle, brightness_percent);
+    ledc_fade_stop(handle->leds_mode, handle->channel);
+    ESP_ERROR_CHECK(ledc_set_duty_and_update(handle->leds_mode, handle->channel, duty, 0));
 
     return ESP_OK;
-}
\ No newline at end of file
+}
+
+esp_err_t backlight_fade_to(const backlight_handle_t* handle, uint8_t brightness_percent, uint32_t fade_ms)
+{
+    if (!handle) {
+        ESP_LOGE(TAG, "Invalid argument: handle is NULL");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (brightness_percent > 100) {
+        ESP_LOGE(TAG, "Invalid argument: brightness_percent is out of range");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (fade_ms == 0) {
+        return backlight_set_brightness(handle, brightness_percent);
+    }
+
+    uint32_t duty = backlight_percent_to_duty(handle, brightness_percent);
+
+    /* A running fade holds the channel until it ends; stop it so this call never blocks. */
+    ledc_fade_stop(handle->leds_mode, handle->channel);
+
+    esp_err_t ret = ledc_set_fade_with_time(handle->leds_mode, handle->channel, duty, (int)fade_ms);
+    if (ret == ESP_OK) {
+        ret = ledc_fade_start(handle->leds_mode, handle->channel, LEDC_FADE_NO_WAIT);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Fade start failed: %s", esp_err_to_name(ret));
+    }
+
+    return ret;
+}
+
+uint32_t backlight_get_duty(const backlight_handle_t* handle)
+{
+    if (!handle) {
+        return 0;
+    }
+
+    uint32_t duty = ledc_get_duty(handle->leds_mode, handle->channel);
+    return (duty == LEDC_ERR_DUTY) ? 0 : duty;
+}
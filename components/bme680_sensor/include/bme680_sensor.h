@@ -58,6 +58,8 @@ typedef struct {
     bool run_in_done;
     /**< True when IAQ can be treated as valid for UI decisions. */
     bool iaq_valid;
+    /**< esp_timer time in microseconds when the measurement was read from the sensor. */
+    int64_t timestamp_us;
 } bme680_sensor_data_t;
 
 /**
@@ -102,6 +104,19 @@ esp_err_t bme680_sensor_set_mode(bme680_sensor_mode_t mode);
  */
 void bme680_sensor_deinit(void);
 
+/**
+ * @brief Release the sensor for deep sleep, keeping the BSEC context in RTC memory.
+ *
+ * Like bme680_sensor_deinit(), but the BSEC state, its timebase and the last
+ * output are kept in RTC memory, and NVS is only written when its periodic save
+ * is due. The next bme680_sensor_init() after a deep-sleep wake restores from
+ * there instead of NVS and continues the BSEC timestamps across the sleep.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if not initialized, or
+ *         ESP_FAIL if the BSEC state could not be read (the sensor is still released).
+ */
+esp_err_t bme680_sensor_suspend(void);
+
 /**
  * @brief Check whether sensor runtime is initialized.
  *
@@ -123,6 +138,26 @@ bool bme680_sensor_is_calibrating(void);
  */
 uint32_t bme680_sensor_get_next_call_delay_ms(void);
 
+/**
+ * @brief Get the exact time until BSEC expects the next read.
+ *
+ * Unlike bme680_sensor_get_next_call_delay_ms() this is not clamped, so it
+ * can be used as a deep-sleep timer (300 s in ULP mode).
+ *
+ * @return Delay in microseconds, 0 if the read is already due.
+ */
+uint64_t bme680_sensor_get_next_call_us(void);
+
+/**
+ * @brief Get the number of bsec_do_steps calls and the time spent in them.
+ *
+ * Counters run since bme680_sensor_init() and restart from zero on re-init.
+ *
+ * @param[out] out_steps Optional, number of BSEC steps.
+ * @param[out] out_total_us Optional, total wall time of those steps in microseconds.
+ */
+void bme680_sensor_get_bsec_stats(uint32_t* out_steps, uint64_t* out_total_us);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,18 +1,22 @@
 #include "bme680_sensor.h"
 
 #include <string.h>
+#include <sys/time.h>
 
 #include "bme68x.h"
 #include "bsec_interface.h"
+#include "bsec_state_store.h"
 #include "driver/gpio.h"
+#include "esp_attr.h"
 #include "esp_log.h"
+#include "esp_pm.h"
 #include "esp_rom_sys.h"
 #include "esp_system.h"
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "nvs.h"
-#include "nvs_flash.h"
+#include "settings.h"
 
 #define BSEC_CHECK_INPUT(x, shift) ((x) & (1U << ((shift) - 1U)))
 
@@ -23,8 +27,9 @@
 #define BSEC_HEATR_PROFILE_LEN 10U
 
 #define BSEC_NVS_NAMESPACE "bme680"
-#define BSEC_NVS_KEY_STATE "bsec_state"
-#define BSEC_NVS_KEY_STATE_LEN "bsec_len"
+#define BSEC_RTC_MAGIC 0x42534543U /* "BSEC" */
+
+_Static_assert(BSEC_MAX_STATE_BLOB_SIZE <= BSEC_STORE_MAX_STATE_SIZE, "BSEC state does not fit a store slot");
 
 extern const uint8_t bsec_iaq_config_start[] asm("_binary_bsec_iaq_config_start");
 extern const uint8_t bsec_iaq_config_end[] asm("_binary_bsec_iaq_config_end");
@@ -41,6 +46,15 @@ typedef struct {
     bool last_saved_run_in_done;
     bme680_sensor_mode_t mode;
     int64_t last_state_save_time_us;
+    int64_t next_call_ns;
+    /* Added to esp_timer time so BSEC timestamps keep counting across deep sleep. */
+    int64_t time_offset_us;
+    /* Held at the CPU ceiling around bsec_do_steps, which is pure number crunching. */
+    esp_pm_lock_handle_t pm_lock;
+    uint32_t bsec_steps;
+    uint64_t bsec_step_us;
+    /* Packed with BSEC_STORE_VERSION(), recorded in each saved state slot. */
+    uint32_t bsec_version;
 
     i2c_bus_handle_t bus;
     i2c_bus_device_handle_t dev_handle;
@@ -58,14 +72,37 @@ typedef struct {
     bme680_sensor_data_t last_output;
 } bme680_sensor_ctx_t;
 
+/* BSEC context kept in RTC memory over deep sleep, so a wake skips the NVS round trip. */
+typedef struct {
+    uint32_t magic;
+    uint32_t state_len;
+    uint8_t state[BSEC_MAX_STATE_BLOB_SIZE];
+    int64_t sensor_time_us;
+    int64_t wall_time_us;
+    int64_t last_state_save_time_us;
+    uint8_t mode;
+    uint8_t last_saved_iaq_accuracy;
+    bool last_saved_stabilization_done;
+    bool last_saved_run_in_done;
+    bme680_sensor_data_t last_output;
+} bme680_rtc_state_t;
+
 static const char* TAG = "bme680_sensor";
 static bme680_sensor_ctx_t s_ctx;
+static RTC_DATA_ATTR bme680_rtc_state_t s_rtc_state;
 
 static void i2c_bus_recovery(gpio_num_t sda_gpio, gpio_num_t scl_gpio);
 
 static int64_t now_us(void)
 {
-    return esp_timer_get_time();
+    return esp_timer_get_time() + s_ctx.time_offset_us;
+}
+
+static int64_t wall_time_us(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000LL + tv.tv_usec;
 }
 
 static float clampf(float value, float min_v, float max_v)
@@ -213,24 +250,13 @@ static esp_err_t bsec_update_subscription_for_mode(bme680_sensor_mode_t mode)
 
 static void bsec_try_init_nvs(void)
 {
-    esp_err_t ret = nvs_flash_init();
-    if (ret == ESP_OK) {
-        return;
-    }
-
-    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
-        ESP_LOGW(TAG, "NVS requires erase, retrying");
-        if (nvs_flash_erase() == ESP_OK) {
-            ret = nvs_flash_init();
-            if (ret == ESP_OK) {
-                return;
-            }
-        }
+    esp_err_t ret = settings_init();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "NVS init failed: %s", esp_err_to_name(ret));
     }
-
-    ESP_LOGW(TAG, "NVS init failed: %s", esp_err_to_name(ret));
 }
 
+/* The state blob is written straight through the shared handle: it must not wait for a debounce. */
 static void bsec_clear_state_nvs(void)
 {
     if (!s_ctx.state_persistence_enabled) {
@@ -238,14 +264,11 @@ static void bsec_clear_state_nvs(void)
     }
 
     nvs_handle_t nvs = 0;
-    if (nvs_open(BSEC_NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK) {
+    if (settings_get_handle(BSEC_NVS_NAMESPACE, &nvs) != ESP_OK) {
         return;
     }
 
-    nvs_erase_key(nvs, BSEC_NVS_KEY_STATE);
-    nvs_erase_key(nvs, BSEC_NVS_KEY_STATE_LEN);
-    nvs_commit(nvs);
-    nvs_close(nvs);
+    bsec_store_clear(nvs);
 }
 
 static void bsec_load_state_nvs(void)
@@ -255,29 +278,24 @@ static void bsec_load_state_nvs(void)
     }
 
     nvs_handle_t nvs = 0;
-    if (nvs_open(BSEC_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+    if (settings_get_handle(BSEC_NVS_NAMESPACE, &nvs) != ESP_OK) {
         return;
     }
 
+    int64_t start_us = esp_timer_get_time();
+    uint8_t state_blob[BSEC_STORE_MAX_STATE_SIZE] = {0};
     uint32_t state_len = 0;
-    esp_err_t ret = nvs_get_u32(nvs, BSEC_NVS_KEY_STATE_LEN, &state_len);
-    if (ret != ESP_OK || state_len == 0U || state_len > BSEC_MAX_STATE_BLOB_SIZE) {
-        nvs_close(nvs);
-        return;
-    }
-
-    uint8_t state_blob[BSEC_MAX_STATE_BLOB_SIZE] = {0};
-    size_t blob_size = state_len;
-    ret = nvs_get_blob(nvs, BSEC_NVS_KEY_STATE, state_blob, &blob_size);
-    nvs_close(nvs);
-    if (ret != ESP_OK || blob_size != state_len) {
+    if (bsec_store_load(nvs, s_ctx.bsec_version, state_blob, &state_len) != ESP_OK) {
         return;
     }
 
     uint8_t work_buffer[BSEC_MAX_WORKBUFFER_SIZE] = {0};
     bsec_library_return_t bsec_ret = bsec_set_state(state_blob, state_len, work_buffer, BSEC_MAX_WORKBUFFER_SIZE);
     if (bsec_check_rslt("bsec_set_state", bsec_ret) == ESP_OK) {
-        ESP_LOGI(TAG, "Loaded BSEC state from NVS (%lu bytes)", (unsigned long)state_len);
+        ESP_LOGI(TAG,
+            "Loaded BSEC state from NVS (%lu bytes) in %lld us",
+            (unsigned long)state_len,
+            (long long)(esp_timer_get_time() - start_us));
     }
 }
 
@@ -307,27 +325,34 @@ static void bsec_save_state_nvs(bool force)
     }
 
     nvs_handle_t nvs = 0;
-    esp_err_t ret = nvs_open(BSEC_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    esp_err_t ret = settings_get_handle(BSEC_NVS_NAMESPACE, &nvs);
     if (ret != ESP_OK) {
         ESP_LOGW(TAG, "Failed to open NVS for BSEC state save: %s", esp_err_to_name(ret));
         return;
     }
 
-    ret = nvs_set_blob(nvs, BSEC_NVS_KEY_STATE, state_blob, state_len);
-    if (ret == ESP_OK) {
-        ret = nvs_set_u32(nvs, BSEC_NVS_KEY_STATE_LEN, state_len);
-    }
-    if (ret == ESP_OK) {
-        ret = nvs_commit(nvs);
-    }
-
-    if (ret == ESP_OK) {
-        s_ctx.last_state_save_time_us = now;
-    } else {
+    size_t record_len = 0;
+    ret = bsec_store_save(nvs, s_ctx.bsec_version, state_blob, state_len, &record_len);
+    if (ret != ESP_OK) {
         ESP_LOGW(TAG, "Failed to persist BSEC state: %s", esp_err_to_name(ret));
+        return;
     }
 
-    nvs_close(nvs);
+    s_ctx.last_state_save_time_us = now;
+    if (record_len > 0U) {
+        /* Projection at the current interval; the old layout wrote the raw state plus a u32 length key. */
+        uint32_t saves_per_day = (24U * 60U * 60U) / interval_sec;
+        bsec_store_stats_t stats = {0};
+        bsec_store_get_stats(&stats);
+        ESP_LOGI(TAG,
+            "BSEC state saved: %lu -> %u bytes, ~%lu bytes/day at this interval (was %lu); %lu saves, %lu unchanged",
+            (unsigned long)state_len,
+            (unsigned int)record_len,
+            (unsigned long)(record_len * saves_per_day),
+            (unsigned long)((state_len + sizeof(uint32_t)) * saves_per_day),
+            (unsigned long)stats.saves,
+            (unsigned long)stats.unchanged);
+    }
 }
 
 static void bsec_maybe_save_state_on_progress(void)
@@ -349,6 +374,73 @@ static void bsec_maybe_save_state_on_progress(void)
     s_ctx.last_saved_run_in_done = s_ctx.last_output.run_in_done;
 }
 
+static esp_err_t bsec_save_state_rtc(void)
+{
+    uint8_t work_buffer[BSEC_MAX_WORKBUFFER_SIZE] = {0};
+    uint32_t state_len = BSEC_MAX_STATE_BLOB_SIZE;
+
+    s_rtc_state.magic = 0;
+    bsec_library_return_t bsec_ret = bsec_get_state(
+        0, s_rtc_state.state, BSEC_MAX_STATE_BLOB_SIZE, work_buffer, BSEC_MAX_WORKBUFFER_SIZE, &state_len);
+    if (bsec_check_rslt("bsec_get_state", bsec_ret) != ESP_OK) {
+        return ESP_FAIL;
+    }
+
+    s_rtc_state.state_len = state_len;
+    s_rtc_state.sensor_time_us = now_us();
+    s_rtc_state.wall_time_us = wall_time_us();
+    s_rtc_state.last_state_save_time_us = s_ctx.last_state_save_time_us;
+    s_rtc_state.mode = (uint8_t)s_ctx.mode;
+    s_rtc_state.last_saved_iaq_accuracy = s_ctx.last_saved_iaq_accuracy;
+    s_rtc_state.last_saved_stabilization_done = s_ctx.last_saved_stabilization_done;
+    s_rtc_state.last_saved_run_in_done = s_ctx.last_saved_run_in_done;
+    s_rtc_state.last_output = s_ctx.last_output;
+    s_rtc_state.magic = BSEC_RTC_MAGIC;
+    return ESP_OK;
+}
+
+/* One-shot: the copy is dropped once used, so a later unrelated deep sleep never restores stale state. */
+static bool bsec_restore_state_rtc(void)
+{
+    if (s_rtc_state.magic != BSEC_RTC_MAGIC || s_rtc_state.state_len == 0U ||
+        s_rtc_state.state_len > BSEC_MAX_STATE_BLOB_SIZE) {
+        return false;
+    }
+    s_rtc_state.magic = 0;
+
+    uint8_t work_buffer[BSEC_MAX_WORKBUFFER_SIZE] = {0};
+    bsec_library_return_t bsec_ret =
+        bsec_set_state(s_rtc_state.state, s_rtc_state.state_len, work_buffer, BSEC_MAX_WORKBUFFER_SIZE);
+    if (bsec_check_rslt("bsec_set_state(rtc)", bsec_ret) != ESP_OK) {
+        return false;
+    }
+
+    int64_t slept_us = wall_time_us() - s_rtc_state.wall_time_us;
+    if (slept_us < 0) {
+        slept_us = 0;
+    }
+    s_ctx.time_offset_us = s_rtc_state.sensor_time_us + slept_us - esp_timer_get_time();
+    s_ctx.last_state_save_time_us = s_rtc_state.last_state_save_time_us;
+    s_ctx.last_saved_iaq_accuracy = s_rtc_state.last_saved_iaq_accuracy;
+    s_ctx.last_saved_stabilization_done = s_rtc_state.last_saved_stabilization_done;
+    s_ctx.last_saved_run_in_done = s_rtc_state.last_saved_run_in_done;
+    s_ctx.last_output = s_rtc_state.last_output;
+    s_ctx.last_output.timestamp_us = 0;
+    s_ctx.iaq_accuracy = s_ctx.last_output.iaq_accuracy;
+    s_ctx.iaq_valid = s_ctx.last_output.iaq_valid;
+
+    if ((bme680_sensor_mode_t)s_rtc_state.mode == BME680_SENSOR_MODE_ULP &&
+        bsec_update_subscription_for_mode(BME680_SENSOR_MODE_ULP) == ESP_OK) {
+        s_ctx.mode = BME680_SENSOR_MODE_ULP;
+    }
+
+    ESP_LOGI(TAG,
+        "Restored BSEC state from RTC (%lu bytes, slept %lld s)",
+        (unsigned long)s_rtc_state.state_len,
+        (long long)(slept_us / 1000000LL));
+    return true;
+}
+
 static esp_err_t bme_apply_settings(const bsec_bme_settings_t* settings)
 {
     if (settings->op_mode == BME68X_SLEEP_MODE) {
@@ -486,7 +578,16 @@ static esp_err_t bme_process_field(
 
     bsec_output_t outputs[BSEC_NUMBER_OUTPUTS] = {0};
     uint8_t n_outputs = BSEC_NUMBER_OUTPUTS;
+    if (s_ctx.pm_lock) {
+        esp_pm_lock_acquire(s_ctx.pm_lock);
+    }
+    int64_t step_start_us = esp_timer_get_time();
     bsec_library_return_t bsec_ret = bsec_do_steps(inputs, n_inputs, outputs, &n_outputs);
+    s_ctx.bsec_step_us += (uint64_t)(esp_timer_get_time() - step_start_us);
+    s_ctx.bsec_steps++;
+    if (s_ctx.pm_lock) {
+        esp_pm_lock_release(s_ctx.pm_lock);
+    }
     if (bsec_check_rslt("bsec_do_steps", bsec_ret) != ESP_OK) {
         return ESP_FAIL;
     }
@@ -641,6 +742,11 @@ esp_err_t bme680_sensor_init(const bme680_sensor_config_t* config)
     s_ctx.bme.delay_us = bme_delay_us;
     s_ctx.bme.amb_temp = 25;
 
+    /* Fails with ESP_ERR_NOT_SUPPORTED without CONFIG_PM_ENABLE; the steps then run unlocked. */
+    if (esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "bsec", &s_ctx.pm_lock) != ESP_OK) {
+        s_ctx.pm_lock = NULL;
+    }
+
     int8_t rslt = bme68x_init(&s_ctx.bme);
     if (bme_check_rslt("bme68x_init", rslt) != ESP_OK) {
         bme680_sensor_deinit();
@@ -661,6 +767,8 @@ esp_err_t bme680_sensor_init(const bme680_sensor_config_t* config)
     bsec_version_t version = {0};
     bsec_ret = bsec_get_version(&version);
     if (bsec_check_rslt("bsec_get_version", bsec_ret) == ESP_OK) {
+        s_ctx.bsec_version =
+            BSEC_STORE_VERSION(version.major, version.minor, version.major_bugfix, version.minor_bugfix);
         ESP_LOGI(
             TAG, "BSEC version %u.%u.%u.%u", version.major, version.minor, version.major_bugfix, version.minor_bugfix);
     }
@@ -673,7 +781,7 @@ esp_err_t bme680_sensor_init(const bme680_sensor_config_t* config)
     if (cold_start_on_power_on) {
         bsec_clear_state_nvs();
         ESP_LOGI(TAG, "BSEC cold-start baseline: power-on reset, persisted state cleared");
-    } else {
+    } else if (reset_reason != ESP_RST_DEEPSLEEP || !bsec_restore_state_rtc()) {
         bsec_load_state_nvs();
     }
 
@@ -694,6 +802,7 @@ esp_err_t bme680_sensor_read(bme680_sensor_data_t* out_data)
         return ESP_FAIL;
     }
 
+    s_ctx.next_call_ns = bme_settings.next_call;
     s_ctx.next_call_delay_ms = bsec_next_call_delay_ms(bme_settings.next_call);
 
     if ((bme_settings.trigger_measurement != 0U) || (bme_settings.op_mode != s_ctx.current_op_mode)) {
@@ -715,6 +824,7 @@ esp_err_t bme680_sensor_read(bme680_sensor_data_t* out_data)
         if (bme_check_rslt("bme68x_get_data", rslt) != ESP_OK || n_fields == 0U) {
             return ESP_FAIL;
         }
+        s_ctx.last_output.timestamp_us = esp_timer_get_time();
 
         for (uint8_t i = 0; i < n_fields; i++) {
             if (bme_process_field(timestamp_ns, bme_settings.op_mode, &fields[i], bme_settings.process_data) !=
@@ -774,9 +884,44 @@ void bme680_sensor_deinit(void)
         i2c_bus_delete(&s_ctx.bus);
     }
 
+    if (s_ctx.pm_lock) {
+        esp_pm_lock_delete(s_ctx.pm_lock);
+    }
+
     memset(&s_ctx, 0, sizeof(s_ctx));
 }
 
+esp_err_t bme680_sensor_suspend(void)
+{
+    if (!s_ctx.initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t ret = bsec_save_state_rtc();
+    /* NVS stays the backup for power loss, on its usual schedule. */
+    bsec_save_state_nvs(false);
+    s_ctx.initialized = false;
+
+    if (s_ctx.dev_handle) {
+        int8_t rslt = bme68x_set_op_mode(BME68X_SLEEP_MODE, &s_ctx.bme);
+        if (rslt != BME68X_OK) {
+            ESP_LOGW(TAG, "bme68x_set_op_mode(sleep) failed during suspend: %d", rslt);
+        }
+        i2c_bus_device_delete(&s_ctx.dev_handle);
+    }
+
+    if (s_ctx.bus) {
+        i2c_bus_delete(&s_ctx.bus);
+    }
+
+    if (s_ctx.pm_lock) {
+        esp_pm_lock_delete(s_ctx.pm_lock);
+    }
+
+    memset(&s_ctx, 0, sizeof(s_ctx));
+    return ret;
+}
+
 bool bme680_sensor_is_initialized(void)
 {
     return s_ctx.initialized;
@@ -795,3 +940,23 @@ uint32_t bme680_sensor_get_next_call_delay_ms(void)
 
     return s_ctx.next_call_delay_ms;
 }
+
+uint64_t bme680_sensor_get_next_call_us(void)
+{
+    if (!s_ctx.initialized || s_ctx.next_call_ns == 0) {
+        return (uint64_t)BSEC_DEFAULT_NEXT_CALL_DELAY_MS * 1000ULL;
+    }
+
+    int64_t delay_us = s_ctx.next_call_ns / 1000LL - now_us();
+    return (delay_us > 0) ? (uint64_t)delay_us : 0U;
+}
+
+void bme680_sensor_get_bsec_stats(uint32_t* out_steps, uint64_t* out_total_us)
+{
+    if (out_steps) {
+        *out_steps = s_ctx.bsec_steps;
+    }
+    if (out_total_us) {
+        *out_total_us = s_ctx.bsec_step_us;
+    }
+}
@@ -0,0 +1,309 @@
+#include "bsec_state_store.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+
+static const char* TAG = "bme680_sensor";
+
+#define BSEC_STORE_FORMAT 1U
+#define BSEC_STORE_FLAG_PACKED 0x0001U
+#define BSEC_STORE_SLOT_COUNT 2U
+/* PackBits worst case: one header byte per 128 literal bytes. */
+#define BSEC_STORE_MAX_PAYLOAD (BSEC_STORE_MAX_STATE_SIZE + (BSEC_STORE_MAX_STATE_SIZE + 127U) / 128U)
+#define BSEC_STORE_LEGACY_KEY_STATE "bsec_state"
+#define BSEC_STORE_LEGACY_KEY_LEN "bsec_len"
+
+typedef struct __attribute__((packed)) {
+    uint16_t format;
+    uint16_t flags;
+    uint32_t seq;
+    uint32_t bsec_version;
+    uint16_t state_len;
+    uint16_t payload_len;
+    /**< CRC32 over the header with this field zeroed, then the payload. */
+    uint32_t crc;
+} bsec_slot_header_t;
+
+typedef struct __attribute__((packed)) {
+    bsec_slot_header_t header;
+    uint8_t payload[BSEC_STORE_MAX_PAYLOAD];
+} bsec_slot_record_t;
+
+static const char* const slot_keys[BSEC_STORE_SLOT_COUNT] = {"bsec_slot_a", "bsec_slot_b"};
+
+/* Slot holding the newest record and its sequence; the next save goes to the other one. */
+static bool s_scanned;
+static int s_newest_slot = -1;
+static uint32_t s_newest_seq;
+/* CRC of the last state saved or loaded, to skip rewriting an unchanged state. */
+static uint32_t s_last_state_crc;
+static bool s_last_state_valid;
+static bool s_legacy_checked;
+static bsec_store_stats_t s_stats;
+
+/* PackBits: a control byte n < 128 is followed by n + 1 literals, n >= 128 repeats the next byte 257 - n times. */
+static size_t packbits_encode(const uint8_t* in, size_t len, uint8_t* out, size_t out_size)
+{
+    size_t i = 0;
+    size_t o = 0;
+    while (i < len) {
+        size_t run = 1;
+        while (i + run < len && run < 128U && in[i + run] == in[i]) {
+            run++;
+        }
+
+        if (run >= 3U) {
+            if (o + 2U > out_size) {
+                return 0;
+            }
+            out[o++] = (uint8_t)(257U - run);
+            out[o++] = in[i];
+            i += run;
+            continue;
+        }
+
+        /* Literals until the next run of three or the 128-byte limit. */
+        size_t start = i;
+        size_t count = 0;
+        while (i < len && count < 128U) {
+            if (i + 2U < len && in[i] == in[i + 1U] && in[i] == in[i + 2U]) {
+                break;
+            }
+            i++;
+            count++;
+        }
+        if (o + 1U + count > out_size) {
+            return 0;
+        }
+        out[o++] = (uint8_t)(count - 1U);
+        memcpy(&out[o], &in[start], count);
+        o += count;
+    }
+    return o;
+}
+
+static size_t packbits_decode(const uint8_t* in, size_t len, uint8_t* out, size_t out_size)
+{
+    size_t i = 0;
+    size_t o = 0;
+    while (i < len) {
+        uint8_t ctrl = in[i++];
+        if (ctrl < 128U) {
+            size_t count = (size_t)ctrl + 1U;
+            if (i + count > len || o + count > out_size) {
+                return 0;
+            }
+            memcpy(&out[o], &in[i], count);
+            i += count;
+            o += count;
+        } else {
+            size_t count = 257U - ctrl;
+            if (i >= len || o + count > out_size) {
+                return 0;
+            }
+            memset(&out[o], in[i++], count);
+            o += count;
+        }
+    }
+    return o;
+}
+
+static uint32_t slot_crc(const bsec_slot_record_t* rec)
+{
+    bsec_slot_header_t header = rec->header;
+    header.crc = 0;
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t*)&header, sizeof(header));
+    return esp_rom_crc32_le(crc, rec->payload, rec->header.payload_len);
+}
+
+/* Newer in sequence order, tolerant of wrap-around. */
+static bool seq_is_newer(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b) > 0;
+}
+
+static bool slot_read(
+    nvs_handle_t nvs, size_t slot, uint32_t bsec_version, bsec_slot_record_t* rec, uint8_t* state, uint32_t* state_len)
+{
+    size_t len = sizeof(*rec);
+    if (nvs_get_blob(nvs, slot_keys[slot], rec, &len) != ESP_OK || len < sizeof(rec->header)) {
+        return false;
+    }
+
+    const bsec_slot_header_t* h = &rec->header;
+    if (h->format != BSEC_STORE_FORMAT || h->payload_len != len - sizeof(*h) ||
+        h->state_len == 0U || h->state_len > BSEC_STORE_MAX_STATE_SIZE) {
+        return false;
+    }
+    if (slot_crc(rec) != h->crc) {
+        ESP_LOGW(TAG, "BSEC state slot %c fails CRC, ignored", 'A' + (int)slot);
+        return false;
+    }
+    /* Bugfix releases keep the state layout; anything else would be rejected by bsec_set_state(). */
+    if ((h->bsec_version >> 16) != (bsec_version >> 16)) {
+        ESP_LOGW(TAG, "BSEC state slot %c is from another BSEC version, ignored", 'A' + (int)slot);
+        return false;
+    }
+
+    if (h->flags & BSEC_STORE_FLAG_PACKED) {
+        if (packbits_decode(rec->payload, h->payload_len, state, BSEC_STORE_MAX_STATE_SIZE) != h->state_len) {
+            return false;
+        }
+    } else {
+        if (h->payload_len != h->state_len) {
+            return false;
+        }
+        memcpy(state, rec->payload, h->state_len);
+    }
+
+    *state_len = h->state_len;
+    return true;
+}
+
+static esp_err_t legacy_load(nvs_handle_t nvs, uint8_t* out_state, uint32_t* out_len)
+{
+    uint32_t state_len = 0;
+    esp_err_t ret = nvs_get_u32(nvs, BSEC_STORE_LEGACY_KEY_LEN, &state_len);
+    if (ret != ESP_OK || state_len == 0U || state_len > BSEC_STORE_MAX_STATE_SIZE) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    size_t blob_size = state_len;
+    ret = nvs_get_blob(nvs, BSEC_STORE_LEGACY_KEY_STATE, out_state, &blob_size);
+    if (ret != ESP_OK || blob_size != state_len) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    *out_len = state_len;
+    return ESP_OK;
+}
+
+/* One read per slot; leaves the newest valid state in out_state, if any. */
+static bool slot_scan(nvs_handle_t nvs, uint32_t bsec_version, uint8_t* out_state, uint32_t* out_len)
+{
+    static bsec_slot_record_t rec;
+    uint8_t state[BSEC_STORE_MAX_STATE_SIZE];
+    uint32_t state_len = 0;
+
+    s_scanned = true;
+    s_newest_slot = -1;
+    for (size_t slot = 0; slot < BSEC_STORE_SLOT_COUNT; slot++) {
+        if (!slot_read(nvs, slot, bsec_version, &rec, state, &state_len)) {
+            continue;
+        }
+        if (s_newest_slot >= 0 && !seq_is_newer(rec.header.seq, s_newest_seq)) {
+            continue;
+        }
+
+        s_newest_slot = (int)slot;
+        s_newest_seq = rec.header.seq;
+        memcpy(out_state, state, state_len);
+        *out_len = state_len;
+    }
+    return s_newest_slot >= 0;
+}
+
+esp_err_t bsec_store_load(nvs_handle_t nvs, uint32_t bsec_version, uint8_t* out_state, uint32_t* out_len)
+{
+    if (!slot_scan(nvs, bsec_version, out_state, out_len)) {
+        if (legacy_load(nvs, out_state, out_len) != ESP_OK) {
+            return ESP_ERR_NOT_FOUND;
+        }
+        ESP_LOGI(TAG, "BSEC state found in the pre-slot keys; moved to slots on the next save");
+    }
+
+    s_last_state_crc = esp_rom_crc32_le(0, out_state, *out_len);
+    s_last_state_valid = true;
+    return ESP_OK;
+}
+
+esp_err_t bsec_store_save(
+    nvs_handle_t nvs, uint32_t bsec_version, const uint8_t* state, uint32_t len, size_t* out_record_len)
+{
+    static bsec_slot_record_t rec;
+    *out_record_len = 0;
+    if (len == 0U || len > BSEC_STORE_MAX_STATE_SIZE) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    uint32_t state_crc = esp_rom_crc32_le(0, state, len);
+    if (s_last_state_valid && state_crc == s_last_state_crc) {
+        s_stats.unchanged++;
+        return ESP_OK;
+    }
+    if (!s_scanned) {
+        /* State came from RTC memory, so the slots were never read: find the newest before overwriting. */
+        uint8_t scratch[BSEC_STORE_MAX_STATE_SIZE];
+        uint32_t scratch_len = 0;
+        (void)slot_scan(nvs, bsec_version, scratch, &scratch_len);
+    }
+
+    size_t packed = packbits_encode(state, len, rec.payload, sizeof(rec.payload));
+    bool use_packed = (packed > 0U && packed < len);
+    if (!use_packed) {
+        memcpy(rec.payload, state, len);
+    }
+
+    size_t slot = (s_newest_slot == 0) ? 1U : 0U;
+    rec.header.format = BSEC_STORE_FORMAT;
+    rec.header.flags = use_packed ? BSEC_STORE_FLAG_PACKED : 0U;
+    rec.header.seq = (s_newest_slot < 0) ? 1U : s_newest_seq + 1U;
+    rec.header.bsec_version = bsec_version;
+    rec.header.state_len = (uint16_t)len;
+    rec.header.payload_len = (uint16_t)(use_packed ? packed : len);
+    rec.header.crc = slot_crc(&rec);
+
+    size_t record_len = sizeof(rec.header) + rec.header.payload_len;
+    esp_err_t ret = nvs_set_blob(nvs, slot_keys[slot], &rec, record_len);
+    if (ret == ESP_OK) {
+        ret = nvs_commit(nvs);
+    }
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    s_newest_slot = (int)slot;
+    s_newest_seq = rec.header.seq;
+    s_last_state_crc = state_crc;
+    s_last_state_valid = true;
+    s_stats.saves++;
+    s_stats.bytes_written += (uint32_t)record_len;
+    s_stats.state_bytes += len;
+    *out_record_len = record_len;
+
+    if (!s_legacy_checked) {
+        /* Only once a slot holds the state; a missing key costs no flash write. */
+        s_legacy_checked = true;
+        bool erased = (nvs_erase_key(nvs, BSEC_STORE_LEGACY_KEY_STATE) == ESP_OK);
+        erased = (nvs_erase_key(nvs, BSEC_STORE_LEGACY_KEY_LEN) == ESP_OK) || erased;
+        if (erased) {
+            nvs_commit(nvs);
+        }
+    }
+    return ESP_OK;
+}
+
+void bsec_store_clear(nvs_handle_t nvs)
+{
+    for (size_t slot = 0; slot < BSEC_STORE_SLOT_COUNT; slot++) {
+        nvs_erase_key(nvs, slot_keys[slot]);
+    }
+    nvs_erase_key(nvs, BSEC_STORE_LEGACY_KEY_STATE);
+    nvs_erase_key(nvs, BSEC_STORE_LEGACY_KEY_LEN);
+    nvs_commit(nvs);
+
+    s_scanned = true;
+    s_newest_slot = -1;
+    s_last_state_valid = false;
+    s_legacy_checked = true;
+}
+
+void bsec_store_get_stats(bsec_store_stats_t* out_stats)
+{
+    if (out_stats) {
+        *out_stats = s_stats;
+    }
+}
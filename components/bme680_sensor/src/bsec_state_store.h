@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "nvs.h"
+
+/*
+ * BSEC state in two NVS slots, written alternately. Each slot is a single
+ * blob: a header (format, sequence, BSEC version, lengths, CRC32) followed by
+ * the PackBits-compressed state, so a torn write can only ever damage the
+ * slot being written and the other one still restores.
+ */
+
+/* Largest state the store accepts; matches BSEC_MAX_STATE_BLOB_SIZE. */
+#define BSEC_STORE_MAX_STATE_SIZE 221U
+
+/**< Packs bsec_version_t as major.minor.major_bugfix.minor_bugfix, one byte each. */
+#define BSEC_STORE_VERSION(major, minor, major_bugfix, minor_bugfix)                                                   \
+    (((uint32_t)(major) << 24) | ((uint32_t)(minor) << 16) | ((uint32_t)(major_bugfix) << 8) | (uint32_t)(minor_bugfix))
+
+typedef struct {
+    /**< Slot records written since boot. */
+    uint32_t saves;
+    /**< Saves skipped because the state had not changed. */
+    uint32_t unchanged;
+    /**< Record bytes (header + payload) written since boot. */
+    uint32_t bytes_written;
+    /**< Uncompressed state bytes those records carried. */
+    uint32_t state_bytes;
+} bsec_store_stats_t;
+
+/**
+ * Read both slots (one read each) and return the newest valid state.
+ * Slots from a different BSEC major.minor are ignored. Falls back to the
+ * pre-slot bsec_state/bsec_len keys when neither slot is valid.
+ *
+ * @return ESP_OK, or ESP_ERR_NOT_FOUND when nothing valid is stored.
+ */
+esp_err_t bsec_store_load(nvs_handle_t nvs, uint32_t bsec_version, uint8_t* out_state, uint32_t* out_len);
+
+/**
+ * Write the state to the older slot and commit. Does nothing when the state
+ * equals the last one saved or loaded. Sets @p out_record_len to the record
+ * size written (0 when skipped).
+ */
+esp_err_t bsec_store_save(
+    nvs_handle_t nvs, uint32_t bsec_version, const uint8_t* state, uint32_t len, size_t* out_record_len);
+
+/** Erase both slots and the pre-slot keys. */
+void bsec_store_clear(nvs_handle_t nvs);
+
+void bsec_store_get_stats(bsec_store_stats_t* out_stats);
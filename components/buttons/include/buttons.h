@@ -35,7 +35,7 @@ typedef struct {
     button_id_t button_id;
     /**< True for long-press event, false for short-press event. */
     bool is_long_press;
-    /**< Event timestamp in microseconds. */
+    /**< esp_timer time in microseconds when the driver detected the event (release or long-press threshold). */
     int64_t timestamp_us;
 } button_event_msg_t;
 
@@ -3,6 +3,7 @@
 #include "button_gpio.h"
 #include "driver/gpio.h"
 #include "esp_log.h"
+#include "esp_sleep.h"
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
@@ -61,6 +62,25 @@ static uint8_t detect_button_active_level(gpio_num_t gpio_num, bool disable_pull
     return active_level;
 }
 
+/*
+ * With enable_power_save the driver stops its poll timer once every button is
+ * idle and restarts it from a level interrupt on the pin, so an idle device has
+ * no periodic button wakeups. The same level has to end light sleep, otherwise
+ * a press would only be seen at the next unrelated wakeup.
+ */
+static bool enable_light_sleep_wakeup(gpio_num_t gpio_num, uint8_t active_level)
+{
+    esp_err_t ret = gpio_wakeup_enable(gpio_num, active_level ? GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL);
+    if (ret == ESP_OK) {
+        ret = esp_sleep_enable_gpio_wakeup();
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "GPIO%d light sleep wakeup failed: %s", (int)gpio_num, esp_err_to_name(ret));
+        return false;
+    }
+    return true;
+}
+
 static void queue_button_event(button_id_t btn_id, bool is_long_press)
 {
     if (s_event_queue == NULL) {
@@ -121,6 +141,7 @@ bool buttons_init(const buttons_config_t* config)
     button_gpio_config_t gpio_cfg_prev = {
         .gpio_num = config->prev_gpio,
         .active_level = 0,
+        .enable_power_save = true,
     };
     gpio_cfg_prev.active_level =
         detect_button_active_level(config->prev_gpio, gpio_cfg_prev.disable_pull, gpio_cfg_prev.active_level);
@@ -131,6 +152,9 @@ bool buttons_init(const buttons_config_t* config)
         iot_button_register_cb(btn_prev, BUTTON_PRESS_UP, NULL, internal_short_press_cb, (void*)(intptr_t)BTN_ID_PREV);
         iot_button_register_cb(
             btn_prev, BUTTON_LONG_PRESS_START, NULL, internal_long_press_cb, (void*)(intptr_t)BTN_ID_PREV);
+        if (!enable_light_sleep_wakeup(config->prev_gpio, gpio_cfg_prev.active_level)) {
+            all_ok = false;
+        }
         ESP_LOGI(TAG, "PREV button OK");
     } else {
         ESP_LOGE(TAG, "Failed to create PREV button");
@@ -141,6 +165,7 @@ bool buttons_init(const buttons_config_t* config)
     button_gpio_config_t gpio_cfg_next = {
         .gpio_num = config->next_gpio,
         .active_level = 0,
+        .enable_power_save = true,
         .disable_pull = true,
     };
     gpio_cfg_next.active_level =
@@ -152,6 +177,9 @@ bool buttons_init(const buttons_config_t* config)
         iot_button_register_cb(btn_next, BUTTON_PRESS_UP, NULL, internal_short_press_cb, (void*)(intptr_t)BTN_ID_NEXT);
         iot_button_register_cb(
             btn_next, BUTTON_LONG_PRESS_START, NULL, internal_long_press_cb, (void*)(intptr_t)BTN_ID_NEXT);
+        if (!enable_light_sleep_wakeup(config->next_gpio, gpio_cfg_next.active_level)) {
+            all_ok = false;
+        }
         ESP_LOGI(TAG, "NEXT button OK");
     } else {
         ESP_LOGE(TAG, "Failed to create NEXT button");
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Deferred logging for hot paths (button handlers under the LVGL lock, the
+ * sensor loop). DLOG_x() stores the format string pointer, the timestamp and
+ * the raw argument words; formatting and the UART write happen later in a
+ * low-priority task.
+ *
+ * Arguments are copied by value, so a %s argument must outlive the entry:
+ * string literals, static name tables and esp_err_to_name() are fine, stack
+ * buffers are not. At most 8 argument words are kept (64-bit integers and
+ * doubles take two); the rest of a longer line is cut off.
+ */
+
+/**
+ * @brief Counters since boot.
+ */
+typedef struct {
+    /**< Entries recorded. */
+    uint32_t written;
+    /**< Entries dropped because the ring was full. */
+    uint32_t dropped;
+    /**< Most entries waiting at once. */
+    uint32_t max_pending;
+} deferred_log_stats_t;
+
+#if CONFIG_DEFERRED_LOG
+#define DLOG_LEVEL(level, tag, format, ...)                                                                            \
+    do {                                                                                                               \
+        if (LOG_LOCAL_LEVEL >= (level)) {                                                                              \
+            deferred_log_write((level), (tag), (format), ##__VA_ARGS__);                                               \
+        }                                                                                                              \
+    } while (0)
+#else
+#define DLOG_LEVEL(level, tag, format, ...) ESP_LOG_LEVEL_LOCAL(level, tag, format, ##__VA_ARGS__)
+#endif
+
+#define DLOG_E(tag, format, ...) DLOG_LEVEL(ESP_LOG_ERROR, tag, format, ##__VA_ARGS__)
+#define DLOG_W(tag, format, ...) DLOG_LEVEL(ESP_LOG_WARN, tag, format, ##__VA_ARGS__)
+#define DLOG_I(tag, format, ...) DLOG_LEVEL(ESP_LOG_INFO, tag, format, ##__VA_ARGS__)
+#define DLOG_D(tag, format, ...) DLOG_LEVEL(ESP_LOG_DEBUG, tag, format, ##__VA_ARGS__)
+
+/**
+ * @brief Start the formatter task.
+ *
+ * Entries recorded before this call wait in the ring and are printed once
+ * the task runs.
+ *
+ * @return ESP_OK, or ESP_ERR_NO_MEM when the task could not be created.
+ */
+esp_err_t deferred_log_init(void);
+
+/**
+ * @brief Record a log line without formatting it; use the DLOG_x() macros.
+ *
+ * Safe from any task, not from ISRs. Never blocks: a full ring drops the
+ * line and counts it.
+ */
+void deferred_log_write(esp_log_level_t level, const char* tag, const char* format, ...)
+    __attribute__((format(printf, 3, 4)));
+
+/**
+ * @brief Print all pending entries from the calling task.
+ *
+ * Call before deep sleep or restart, where the formatter task would not get
+ * to run again.
+ */
+void deferred_log_flush(void);
+
+/**
+ * @brief Get counters since boot.
+ *
+ * @param[out] out_stats Output counters.
+ */
+void deferred_log_get_stats(deferred_log_stats_t* out_stats);
+
+#ifdef __cplusplus
+}
+#endif
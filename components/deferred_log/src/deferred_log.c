@@ -0,0 +1,450 @@
+#include "deferred_log.h"
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#if CONFIG_DEFERRED_LOG
+static const char* TAG = "dlog";
+
+#define DLOG_MAX_WORDS 8U
+#define DLOG_RING_MASK ((uint32_t)CONFIG_DEFERRED_LOG_RING_ENTRIES - 1U)
+#define DLOG_LINE_MAX 192U
+#define DLOG_SPEC_MAX 24U
+#define DLOG_TASK_STACK_SIZE 3072
+
+_Static_assert((CONFIG_DEFERRED_LOG_RING_ENTRIES & (CONFIG_DEFERRED_LOG_RING_ENTRIES - 1)) == 0,
+    "CONFIG_DEFERRED_LOG_RING_ENTRIES must be a power of two");
+
+typedef struct {
+    /**< Slot turn, relative to the slot index so that a zeroed ring is empty (bounded MPMC queue sequence). */
+    uint32_t turn;
+    uint8_t level;
+    uint8_t word_count;
+    /**< More arguments than DLOG_MAX_WORDS; the line is cut off there. */
+    bool truncated;
+    const char* tag;
+    const char* format;
+    uint32_t timestamp_ms;
+    uint32_t words[DLOG_MAX_WORDS];
+} dlog_entry_t;
+
+typedef enum {
+    DLOG_ARG_NONE = 0,
+    DLOG_ARG_INT,
+    DLOG_ARG_LONG,
+    DLOG_ARG_INT64,
+    DLOG_ARG_DOUBLE,
+    DLOG_ARG_PTR,
+} dlog_arg_t;
+
+typedef struct {
+    /**< Conversion text from '%' up to and including the conversion character. */
+    const char* start;
+    size_t len;
+    /**< Width and precision given as '*', each taking an int argument first. */
+    uint8_t stars;
+    dlog_arg_t arg;
+} dlog_spec_t;
+
+static dlog_entry_t s_ring[CONFIG_DEFERRED_LOG_RING_ENTRIES];
+static uint32_t s_head;
+/* Only advanced with s_consumer_lock held. */
+static uint32_t s_tail;
+static SemaphoreHandle_t s_consumer_lock;
+static TaskHandle_t s_task;
+static uint32_t s_reported_drops;
+static deferred_log_stats_t s_stats;
+
+/*
+ * Next conversion at or after p. Returns the text after it, or NULL at the end
+ * of the format. "%%" comes back as DLOG_ARG_NONE with no stars.
+ */
+static const char* dlog_next_spec(const char* p, dlog_spec_t* spec)
+{
+    p = strchr(p, '%');
+    if (p == NULL) {
+        return NULL;
+    }
+
+    spec->start = p++;
+    spec->stars = 0;
+    spec->arg = DLOG_ARG_NONE;
+    while (*p && strchr("-+ #0", *p)) {
+        p++;
+    }
+    if (*p == '*') {
+        spec->stars++;
+        p++;
+    }
+    while (*p >= '0' && *p <= '9') {
+        p++;
+    }
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            spec->stars++;
+            p++;
+        }
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+    }
+
+    int longs = 0;
+    bool wide = false;
+    while (*p && strchr("hlzjtL", *p)) {
+        if (*p == 'l') {
+            longs++;
+        } else if (*p == 'j' || *p == 'L') {
+            wide = true;
+        } else if (*p == 'z' || *p == 't') {
+            longs = (longs > 0) ? longs : 1;
+        }
+        p++;
+    }
+
+    switch (*p) {
+    case 'd':
+    case 'i':
+    case 'u':
+    case 'o':
+    case 'x':
+    case 'X':
+        spec->arg = (longs >= 2 || wide) ? DLOG_ARG_INT64 : ((longs == 1) ? DLOG_ARG_LONG : DLOG_ARG_INT);
+        break;
+    case 'c':
+        spec->arg = DLOG_ARG_INT;
+        break;
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+        spec->arg = DLOG_ARG_DOUBLE;
+        break;
+    case 's':
+    case 'p':
+        spec->arg = DLOG_ARG_PTR;
+        break;
+    case '%':
+        break;
+    default:
+        /* %n or a malformed conversion: stop here, like a truncated line. */
+        return NULL;
+    }
+
+    p++;
+    spec->len = (size_t)(p - spec->start);
+    return p;
+}
+
+static uint8_t dlog_arg_words(dlog_arg_t arg)
+{
+    return (arg == DLOG_ARG_INT64 || arg == DLOG_ARG_DOUBLE) ? 2U : ((arg == DLOG_ARG_NONE) ? 0U : 1U);
+}
+
+/* Copy the arguments as raw words; no formatting. */
+static void dlog_capture(dlog_entry_t* e, const char* format, va_list args)
+{
+    uint8_t n = 0;
+    dlog_spec_t spec;
+    const char* p = format;
+    while ((p = dlog_next_spec(p, &spec)) != NULL) {
+        if ((uint32_t)n + spec.stars + dlog_arg_words(spec.arg) > DLOG_MAX_WORDS) {
+            e->truncated = true;
+            break;
+        }
+        for (uint8_t i = 0; i < spec.stars; i++) {
+            e->words[n++] = (uint32_t)va_arg(args, int);
+        }
+
+        switch (spec.arg) {
+        case DLOG_ARG_INT:
+            e->words[n++] = (uint32_t)va_arg(args, int);
+            break;
+        case DLOG_ARG_LONG:
+            e->words[n++] = (uint32_t)va_arg(args, long);
+            break;
+        case DLOG_ARG_INT64: {
+            uint64_t v = (uint64_t)va_arg(args, long long);
+            memcpy(&e->words[n], &v, sizeof(v));
+            n += 2U;
+            break;
+        }
+        case DLOG_ARG_DOUBLE: {
+            double v = va_arg(args, double);
+            memcpy(&e->words[n], &v, sizeof(v));
+            n += 2U;
+            break;
+        }
+        case DLOG_ARG_PTR:
+            e->words[n++] = (uint32_t)(uintptr_t)va_arg(args, void*);
+            break;
+        default:
+            break;
+        }
+    }
+    e->word_count = n;
+}
+
+void deferred_log_write(esp_log_level_t level, const char* tag, const char* format, ...)
+{
+    uint32_t pos = __atomic_load_n(&s_head, __ATOMIC_RELAXED);
+    dlog_entry_t* e;
+    for (;;) {
+        uint32_t idx = pos & DLOG_RING_MASK;
+        e = &s_ring[idx];
+        uint32_t seq = __atomic_load_n(&e->turn, __ATOMIC_ACQUIRE) + idx;
+        int32_t diff = (int32_t)(seq - pos);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&s_head, &pos, pos + 1U, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            __atomic_add_fetch(&s_stats.dropped, 1U, __ATOMIC_RELAXED);
+            return;
+        } else {
+            pos = __atomic_load_n(&s_head, __ATOMIC_RELAXED);
+        }
+    }
+
+    e->level = (uint8_t)level;
+    e->tag = tag;
+    e->format = format;
+    e->timestamp_ms = esp_log_timestamp();
+    e->truncated = false;
+    va_list args;
+    va_start(args, format);
+    dlog_capture(e, format, args);
+    va_end(args);
+
+    uint32_t idx = pos & DLOG_RING_MASK;
+    __atomic_store_n(&e->turn, pos + 1U - idx, __ATOMIC_RELEASE);
+
+    __atomic_add_fetch(&s_stats.written, 1U, __ATOMIC_RELAXED);
+    uint32_t pending = pos + 1U - __atomic_load_n(&s_tail, __ATOMIC_RELAXED);
+    if (pending > s_stats.max_pending) {
+        s_stats.max_pending = pending;
+    }
+
+    TaskHandle_t task = s_task;
+    if (task != NULL) {
+        xTaskNotifyGive(task);
+    }
+}
+
+/* Format one conversion from its recorded words. */
+static void dlog_format_spec(const dlog_spec_t* spec, const uint32_t* words, char* out, size_t out_size)
+{
+    if (spec->len >= DLOG_SPEC_MAX) {
+        out[0] = '\0';
+        return;
+    }
+
+    /* Rewrite '*' as the recorded value so each case below takes one argument. */
+    char fmt[DLOG_SPEC_MAX + 24];
+    size_t f = 0;
+    uint8_t n = 0;
+    for (size_t i = 0; i < spec->len; i++) {
+        if (spec->start[i] == '*') {
+            f += (size_t)snprintf(&fmt[f], sizeof(fmt) - f, "%d", (int)words[n++]);
+        } else {
+            fmt[f++] = spec->start[i];
+        }
+    }
+    fmt[f] = '\0';
+
+    switch (spec->arg) {
+    case DLOG_ARG_INT:
+        snprintf(out, out_size, fmt, (int)words[n]);
+        break;
+    case DLOG_ARG_LONG:
+        snprintf(out, out_size, fmt, (long)words[n]);
+        break;
+    case DLOG_ARG_INT64: {
+        long long v;
+        memcpy(&v, &words[n], sizeof(v));
+        snprintf(out, out_size, fmt, v);
+        break;
+    }
+    case DLOG_ARG_DOUBLE: {
+        double v;
+        memcpy(&v, &words[n], sizeof(v));
+        snprintf(out, out_size, fmt, v);
+        break;
+    }
+    case DLOG_ARG_PTR:
+        snprintf(out, out_size, fmt, (void*)(uintptr_t)words[n]);
+        break;
+    default:
+        snprintf(out, out_size, "%%");
+        break;
+    }
+}
+
+static void dlog_print(const dlog_entry_t* e)
+{
+    static const char letters[] = {'N', 'E', 'W', 'I', 'D', 'V'};
+    char line[DLOG_LINE_MAX];
+    size_t len = 0;
+    uint8_t used = 0;
+    dlog_spec_t spec;
+    const char* p = e->format;
+    const char* next;
+
+    while (len < sizeof(line) - 1U && (next = dlog_next_spec(p, &spec)) != NULL) {
+        size_t literal = (size_t)(spec.start - p);
+        if (literal > sizeof(line) - 1U - len) {
+            literal = sizeof(line) - 1U - len;
+        }
+        memcpy(&line[len], p, literal);
+        len += literal;
+
+        uint8_t need = spec.stars + dlog_arg_words(spec.arg);
+        if (need > 0U && used + need > e->word_count) {
+            p = NULL;
+            break;
+        }
+        dlog_format_spec(&spec, &e->words[used], &line[len], sizeof(line) - len);
+        used += need;
+        len += strlen(&line[len]);
+        p = next;
+    }
+    if (p != NULL && len < sizeof(line) - 1U) {
+        size_t rest = strlen(p);
+        if (rest > sizeof(line) - 1U - len) {
+            rest = sizeof(line) - 1U - len;
+        }
+        memcpy(&line[len], p, rest);
+        len += rest;
+    }
+    line[len] = '\0';
+
+    char letter = (e->level < sizeof(letters)) ? letters[e->level] : '?';
+    esp_log_write((esp_log_level_t)e->level,
+        e->tag,
+        "%c (%lu) %s: %s%s\n",
+        letter,
+        (unsigned long)e->timestamp_ms,
+        e->tag,
+        line,
+        e->truncated ? " [...]" : "");
+}
+
+/* Single consumer: callers hold s_consumer_lock. */
+static void dlog_drain(void)
+{
+    for (;;) {
+        uint32_t pos = s_tail;
+        uint32_t idx = pos & DLOG_RING_MASK;
+        dlog_entry_t* e = &s_ring[idx];
+        uint32_t seq = __atomic_load_n(&e->turn, __ATOMIC_ACQUIRE) + idx;
+        if ((int32_t)(seq - (pos + 1U)) < 0) {
+            break;
+        }
+
+        dlog_entry_t copy = *e;
+        __atomic_store_n(&e->turn, pos + (uint32_t)CONFIG_DEFERRED_LOG_RING_ENTRIES - idx, __ATOMIC_RELEASE);
+        __atomic_store_n(&s_tail, pos + 1U, __ATOMIC_RELAXED);
+        dlog_print(&copy);
+    }
+
+    uint32_t dropped = __atomic_load_n(&s_stats.dropped, __ATOMIC_RELAXED);
+    if (dropped != s_reported_drops) {
+        ESP_LOGW(TAG,
+            "%lu deferred log line(s) dropped, ring full (%lu total)",
+            (unsigned long)(dropped - s_reported_drops),
+            (unsigned long)dropped);
+        s_reported_drops = dropped;
+    }
+}
+
+static void dlog_task(void* arg)
+{
+    (void)arg;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        xSemaphoreTake(s_consumer_lock, portMAX_DELAY);
+        dlog_drain();
+        xSemaphoreGive(s_consumer_lock);
+    }
+}
+
+esp_err_t deferred_log_init(void)
+{
+    if (s_task != NULL) {
+        return ESP_OK;
+    }
+
+    if (s_consumer_lock == NULL) {
+        s_consumer_lock = xSemaphoreCreateMutex();
+        if (s_consumer_lock == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    TaskHandle_t task = NULL;
+    if (xTaskCreate(dlog_task, "dlog", DLOG_TASK_STACK_SIZE, NULL, CONFIG_DEFERRED_LOG_TASK_PRIORITY, &task) !=
+        pdPASS) {
+        ESP_LOGE(TAG, "Failed to create formatter task");
+        return ESP_ERR_NO_MEM;
+    }
+    s_task = task;
+    /* Lines recorded before the task existed. */
+    xTaskNotifyGive(task);
+    return ESP_OK;
+}
+
+void deferred_log_flush(void)
+{
+    if (s_consumer_lock == NULL) {
+        return;
+    }
+
+    xSemaphoreTake(s_consumer_lock, portMAX_DELAY);
+    dlog_drain();
+    xSemaphoreGive(s_consumer_lock);
+}
+
+void deferred_log_get_stats(deferred_log_stats_t* out_stats)
+{
+    if (out_stats) {
+        out_stats->written = __atomic_load_n(&s_stats.written, __ATOMIC_RELAXED);
+        out_stats->dropped = __atomic_load_n(&s_stats.dropped, __ATOMIC_RELAXED);
+        out_stats->max_pending = s_stats.max_pending;
+    }
+}
+#else
+void deferred_log_write(esp_log_level_t level, const char* tag, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    esp_log_writev(level, tag, format, args);
+    va_end(args);
+}
+
+esp_err_t deferred_log_init(void)
+{
+    return ESP_OK;
+}
+
+void deferred_log_flush(void)
+{
+}
+
+void deferred_log_get_stats(deferred_log_stats_t* out_stats)
+{
+    if (out_stats) {
+        memset(out_stats, 0, sizeof(*out_stats));
+    }
+}
+#endif
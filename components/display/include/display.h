@@ -1,14 +1,22 @@
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
 #include "esp_err.h"
 #include "esp_lcd_panel_io.h"
 #include "esp_lcd_panel_ops.h"
+#include "sdkconfig.h"
 
 #define WIDTH 135
 #define HEIGHT 240
 
 #define PIN_NUM_BL 4
 
+/* Pixels per LVGL draw buffer, see CONFIG_DISPLAY_DRAW_BUFFER_DIVISOR. */
+#define DISPLAY_DRAW_BUFFER_PIXELS (WIDTH * HEIGHT / CONFIG_DISPLAY_DRAW_BUFFER_DIVISOR)
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -19,15 +27,74 @@ extern "C" {
 typedef struct {
     esp_lcd_panel_io_handle_t io_handle; /*!< Handle for the LCD IO interface (SPI) */
     esp_lcd_panel_handle_t panel_handle; /*!< Handle for the LCD panel controller */
+    uint32_t pclk_hz;                    /*!< SPI clock the panel was brought up at (after fallback) */
 } display_handles_t;
 
 /**
  * @brief Initialize the display hardware
  *
+ * Tries CONFIG_DISPLAY_SPI_CLOCK_MHZ first and falls back to lower clocks
+ * if the panel cannot be brought up or fails the readback check.
+ *
  * @return display_handles_t Structure containing initialized IO and Panel handles.
  */
 display_handles_t display_init(void);
 
+/**
+ * @brief Clear the panel and draw a boot splash image without LVGL
+ *
+ * @p img_bin is an LVGL v8 true-color image file (4 byte header followed by
+ * RGB565 pixels in panel byte order, i.e. converted for LV_COLOR_16_SWAP) and
+ * may live in flash. Blocks until every transfer is done.
+ *
+ * @param[in] handles Handles returned by display_init()
+ * @param[in] img_bin Image file contents
+ * @param[in] img_bin_size Size of @p img_bin in bytes
+ * @param[in] x Left edge of the image on screen
+ * @param[in] y Top edge of the image on screen
+ * @return
+ *         - ESP_OK on success
+ *         - ESP_ERR_INVALID_ARG if a handle is missing or the image does not fit on screen
+ *         - ESP_ERR_INVALID_SIZE if the image is not a complete true-color image
+ *         - ESP_ERR_NO_MEM if no DMA memory is left for the staging buffer
+ */
+esp_err_t display_draw_splash(const display_handles_t* handles, const uint8_t* img_bin, size_t img_bin_size, int x, int y);
+
+/**
+ * @brief Put the panel into sleep mode (DISPOFF + SLPIN)
+ *
+ * Waits for queued color transfers first. With CONFIG_DISPLAY_SLEEP_RELEASE_BUS
+ * the panel IO is deleted and the SPI bus freed as well; @p handles then hold
+ * NULL until display_wake() recreates them. Frame memory is kept otherwise.
+ *
+ * @param[in,out] handles Handles returned by display_init()
+ * @return ESP_OK on success, or the error of the failed panel command
+ */
+esp_err_t display_sleep(display_handles_t* handles);
+
+/**
+ * @brief Bring the panel out of sleep mode (SLPOUT + DISPON)
+ *
+ * If the bus was released, it is initialized again and the panel recreated at
+ * the clock it ran at before; @p handles are updated in that case.
+ *
+ * @param[in,out] handles Handles passed to display_sleep()
+ * @param[out] out_ram_lost Optional, set when the panel was reset and its frame memory must be redrawn
+ * @return ESP_OK on success
+ */
+esp_err_t display_wake(display_handles_t* handles, bool* out_ram_lost);
+
+/**
+ * @brief Measure full-frame flush time and throughput for every clock/buffer size
+ *
+ * Must be called before the handles are handed to LVGL: the panel is recreated
+ * for every clock step and @p handles is updated to the final (configured) panel.
+ * Does nothing unless CONFIG_DISPLAY_FLUSH_BENCHMARK is enabled.
+ *
+ * @param[in,out] handles Handles returned by display_init()
+ */
+void display_run_flush_benchmark(display_handles_t* handles);
+
 #ifdef __cplusplus
 }
-#endif
\ No newline at end of file
+#endif
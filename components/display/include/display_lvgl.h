@@ -0,0 +1,150 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "display.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Accumulated LVGL render/flush statistics.
+ */
+typedef struct {
+    uint32_t frames;        /*!< Refresh cycles that flushed at least one pixel */
+    uint64_t refresh_us;    /*!< Wall time spent inside those refresh cycles */
+    uint64_t flush_us;      /*!< Time from draw_bitmap to SPI transfer done */
+    uint64_t flushed_px;    /*!< Pixels sent to the panel */
+    size_t draw_buf_bytes;  /*!< Internal RAM held by the LVGL draw buffers */
+} display_lvgl_stats_t;
+
+/**
+ * @brief Origin of a traced event.
+ */
+typedef enum {
+    DISPLAY_LATENCY_SAMPLE = 0, /*!< Sensor measurement shown on screen */
+    DISPLAY_LATENCY_PRESS,      /*!< Button press reflected on screen */
+    DISPLAY_LATENCY_SOURCE_COUNT,
+} display_latency_source_t;
+
+#define DISPLAY_LATENCY_BUCKETS 10
+
+/**
+ * @brief Latency histogram from event origin to flush done.
+ *
+ * Bucket i counts events with latency below display_latency_bucket_ms[i];
+ * the last bucket is unbounded. Stage sums split the total into origin to
+ * hand-off (sensor loop / button queue), hand-off to UI update (UI timer and
+ * LVGL lock waits) and UI update to pixels on the panel.
+ */
+typedef struct {
+    uint32_t count;
+    uint32_t expired;        /*!< Marks dropped without reaching the panel */
+    uint32_t buckets[DISPLAY_LATENCY_BUCKETS];
+    uint32_t max_us;
+    uint64_t total_us;
+    uint64_t origin_to_queued_us;
+    uint64_t queued_to_applied_us;
+    uint64_t applied_to_flushed_us;
+} display_latency_hist_t;
+
+extern const uint16_t display_latency_bucket_ms[DISPLAY_LATENCY_BUCKETS - 1];
+
+/**
+ * @brief Register the panel with esp_lvgl_port using the configured render mode
+ *
+ * Partial mode uses two DMA buffers of DISPLAY_DRAW_BUFFER_PIXELS. Direct mode
+ * (CONFIG_DISPLAY_RENDER_MODE_DIRECT) uses one full-frame DMA buffer and flushes
+ * only the dirty row bands. Must be called after lvgl_port_init().
+ *
+ * @param[in] handles Display hardware handles
+ * @return LVGL display, or NULL on failure
+ */
+lv_disp_t* display_lvgl_add(const display_handles_t* handles);
+
+/**
+ * @brief Stop rendering and put the panel to sleep
+ *
+ * Pauses the LVGL refresh timer, sends the panel to sleep via display_sleep()
+ * and, with CONFIG_DISPLAY_SLEEP_FREE_DRAW_BUFFERS, frees the draw buffers.
+ * UI calls stay allowed while asleep; their changes are drawn after wake.
+ * lv_refr_now() must not be called while asleep. Takes the LVGL lock
+ * (recursive); no-op if already asleep.
+ *
+ * @param[in,out] handles Display hardware handles
+ * @return ESP_OK on success, or the panel command error
+ */
+esp_err_t display_lvgl_sleep(display_handles_t* handles);
+
+/**
+ * @brief Wake the panel and resume rendering
+ *
+ * Restores the draw buffers if they were freed, re-attaches the flush path if
+ * the panel IO was recreated, invalidates the screen when the panel or frame
+ * buffer lost its content and logs the wake latency. No-op if not asleep.
+ *
+ * @param[in,out] handles Display hardware handles passed to display_lvgl_sleep()
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the draw buffers could not be reallocated
+ */
+esp_err_t display_lvgl_wake(display_handles_t* handles);
+
+/**
+ * @brief Render pending changes and wait until they are on the panel
+ *
+ * Runs one refresh cycle synchronously and returns once the last transfer of
+ * it is done, e.g. to have a correct frame on the glass before the backlight
+ * comes on. Takes the LVGL lock (recursive); no-op while asleep.
+ *
+ * @return Time spent rendering and flushing in microseconds
+ */
+uint32_t display_lvgl_render_now(void);
+
+/**
+ * @brief Check whether the display is in the deep off state
+ */
+bool display_lvgl_is_asleep(void);
+
+/**
+ * @brief Get render/flush statistics accumulated since the last reset
+ *
+ * @param[out] out_stats Output statistics
+ * @param[in] reset Clear the counters after reading
+ */
+void display_lvgl_get_stats(display_lvgl_stats_t* out_stats, bool reset);
+
+/**
+ * @brief Trace an event whose UI change was just applied
+ *
+ * Call with the LVGL lock held, right after the UI calls caused by the event.
+ * If anything on screen is invalidated, the event is completed when the frame
+ * containing it finishes flushing. No-op unless CONFIG_DISPLAY_LATENCY_TRACE.
+ *
+ * @param[in] source Event origin
+ * @param[in] origin_us esp_timer time of the measurement or press
+ * @param[in] queued_us esp_timer time the event was handed to the UI side
+ */
+void display_lvgl_trace_latency(display_latency_source_t source, int64_t origin_us, int64_t queued_us);
+
+/**
+ * @brief Get the latency histogram of one event source
+ *
+ * @param[in] source Event origin
+ * @param[out] out_hist Output histogram
+ * @param[in] reset Clear the histogram after reading
+ */
+void display_lvgl_get_latency(display_latency_source_t source, display_latency_hist_t* out_hist, bool reset);
+
+/**
+ * @brief Log the latency histograms of all sources
+ *
+ * @param[in] reset Clear the histograms after logging
+ */
+void display_lvgl_log_latency(bool reset);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,10 +1,21 @@
 #include "display.h"
 
+#include <stdbool.h>
+#include <string.h>
+
 #include "driver/gpio.h"
 #include "driver/spi_master.h"
+#include "esp_heap_caps.h"
+#include "esp_lcd_panel_commands.h"
 #include "esp_lcd_panel_io.h"
 #include "esp_lcd_panel_ops.h"
 #include "esp_lcd_panel_vendor.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static const char* TAG = "display";
 
 #define PIN_NUM_MISO -1
 #define PIN_NUM_MOSI 19
@@ -14,12 +25,41 @@
 #define PIN_NUM_RST 23
 
 #define LCD_HOST SPI2_HOST
-#define SPI_CLOCK_HZ (27 * 1000 * 1000)
+#define SPI_CLOCK_HZ (CONFIG_DISPLAY_SPI_CLOCK_MHZ * 1000 * 1000)
 
-display_handles_t display_init(void)
+#define FLUSH_BENCH_FRAMES 20
+
+/* LVGL v8 image header: cf:5 always_zero:3 reserved:2 w:11 h:11, little endian. */
+#define SPLASH_HEADER_BYTES 4
+#define SPLASH_CF_TRUE_COLOR 4
+#define SPLASH_CHUNK_PIXELS (WIDTH * 16)
+
+/* ST7789 timing: 5 ms after SLPIN/SLPOUT before the next command, and SLPIN
+ * is not accepted within 120 ms of SLPOUT. */
+#define PANEL_SLEEP_SETTLE_MS 5
+#define PANEL_SLEEP_OUT_TO_IN_MS 120
+
+/*
+ * Clock steps, highest first, for the flush benchmark and for display_init(),
+ * which moves to a lower step only when bringing the panel up returns an error.
+ * That is not a signal check: a clock that initializes but corrupts pixels is
+ * kept. SCLK and MOSI go through the GPIO matrix, so 40 MHz is the ceiling.
+ */
+static const uint32_t spi_clock_ladder_hz[] = {
+    40 * 1000 * 1000,
+    27 * 1000 * 1000,
+};
+
+static int64_t s_sleep_out_us;
+static bool s_bus_released;
+
+static void display_delay_ms(uint32_t ms)
 {
-    display_handles_t handles = {0};
+    vTaskDelay(pdMS_TO_TICKS(ms) + 1);
+}
 
+static esp_err_t display_init_bus(void)
+{
     spi_bus_config_t buscfg = {
         .sclk_io_num = PIN_NUM_SCLK,
         .mosi_io_num = PIN_NUM_MOSI,
@@ -28,33 +68,356 @@ display_handles_t display_init(void)
         .quadhd_io_num = -1,
         .max_transfer_sz = WIDTH * HEIGHT * sizeof(uint16_t),
     };
-    ESP_ERROR_CHECK(spi_bus_initialize(LCD_HOST, &buscfg, SPI_DMA_CH_AUTO));
+    return spi_bus_initialize(LCD_HOST, &buscfg, SPI_DMA_CH_AUTO);
+}
+
+static void display_delete_panel(display_handles_t* handles)
+{
+    if (handles->panel_handle) {
+        esp_lcd_panel_del(handles->panel_handle);
+        handles->panel_handle = NULL;
+    }
+    if (handles->io_handle) {
+        esp_lcd_panel_io_del(handles->io_handle);
+        handles->io_handle = NULL;
+    }
+    handles->pclk_hz = 0;
+}
+
+static esp_err_t display_verify_panel(esp_lcd_panel_io_handle_t io_handle)
+{
+#if PIN_NUM_MISO >= 0
+    /* RDDID answers with a dummy byte followed by the three ID bytes. */
+    uint8_t id[4] = {0};
+    esp_err_t ret = esp_lcd_panel_io_rx_param(io_handle, LCD_CMD_RDDID, id, sizeof(id));
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    bool all_zero = (id[1] | id[2] | id[3]) == 0x00;
+    bool all_ones = (id[1] & id[2] & id[3]) == 0xFF;
+    if (all_zero || all_ones) {
+        ESP_LOGW(TAG, "Panel readback failed (ID %02X %02X %02X)", id[1], id[2], id[3]);
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    return ESP_OK;
+#else
+    /* MISO is not wired on this board, so the panel cannot be read back. */
+    (void)io_handle;
+    return ESP_OK;
+#endif
+}
+
+static esp_err_t display_configure_panel(esp_lcd_panel_handle_t panel_handle)
+{
+    esp_err_t ret = esp_lcd_panel_reset(panel_handle);
+    if (ret == ESP_OK) {
+        ret = esp_lcd_panel_init(panel_handle);
+    }
+    if (ret == ESP_OK) {
+        ret = esp_lcd_panel_invert_color(panel_handle, true);
+    }
+    if (ret == ESP_OK) {
+        ret = esp_lcd_panel_swap_xy(panel_handle, true);
+    }
+    if (ret == ESP_OK) {
+        ret = esp_lcd_panel_mirror(panel_handle, false, true);
+    }
+    if (ret == ESP_OK) {
+        ret = esp_lcd_panel_set_gap(panel_handle, 52, 40);
+    }
+    if (ret == ESP_OK) {
+        ret = esp_lcd_panel_disp_on_off(panel_handle, true);
+    }
+    return ret;
+}
 
+static esp_err_t display_create_panel(uint32_t pclk_hz, display_handles_t* handles)
+{
     esp_lcd_panel_io_spi_config_t io_config = {
         .dc_gpio_num = PIN_NUM_DC,
         .cs_gpio_num = PIN_NUM_CS,
-        .pclk_hz = SPI_CLOCK_HZ,
+        .pclk_hz = pclk_hz,
         .lcd_cmd_bits = 8,
         .lcd_param_bits = 8,
         .spi_mode = 0,
-        .trans_queue_depth = 10,
+        .trans_queue_depth = CONFIG_DISPLAY_SPI_TRANS_QUEUE_DEPTH,
     };
-    ESP_ERROR_CHECK(esp_lcd_new_panel_io_spi((esp_lcd_spi_bus_handle_t)LCD_HOST, &io_config, &handles.io_handle));
+    esp_err_t ret = esp_lcd_new_panel_io_spi((esp_lcd_spi_bus_handle_t)LCD_HOST, &io_config, &handles->io_handle);
 
-    esp_lcd_panel_dev_config_t panel_config = {
-        .reset_gpio_num = PIN_NUM_RST,
-        .rgb_ele_order = LCD_RGB_ELEMENT_ORDER_RGB,
-        .bits_per_pixel = 16,
-    };
-    ESP_ERROR_CHECK(esp_lcd_new_panel_st7789(handles.io_handle, &panel_config, &handles.panel_handle));
+    if (ret == ESP_OK) {
+        esp_lcd_panel_dev_config_t panel_config = {
+            .reset_gpio_num = PIN_NUM_RST,
+            .rgb_ele_order = LCD_RGB_ELEMENT_ORDER_RGB,
+            .bits_per_pixel = 16,
+        };
+        ret = esp_lcd_new_panel_st7789(handles->io_handle, &panel_config, &handles->panel_handle);
+    }
+    if (ret == ESP_OK) {
+        ret = display_configure_panel(handles->panel_handle);
+    }
+    if (ret == ESP_OK) {
+        ret = display_verify_panel(handles->io_handle);
+    }
+
+    if (ret != ESP_OK) {
+        display_delete_panel(handles);
+        return ret;
+    }
+
+    handles->pclk_hz = pclk_hz;
+    return ESP_OK;
+}
+
+display_handles_t display_init(void)
+{
+    display_handles_t handles = {0};
 
-    ESP_ERROR_CHECK(esp_lcd_panel_reset(handles.panel_handle));
-    ESP_ERROR_CHECK(esp_lcd_panel_init(handles.panel_handle));
-    ESP_ERROR_CHECK(esp_lcd_panel_invert_color(handles.panel_handle, true));
-    ESP_ERROR_CHECK(esp_lcd_panel_swap_xy(handles.panel_handle, true));
-    ESP_ERROR_CHECK(esp_lcd_panel_mirror(handles.panel_handle, false, true));
-    ESP_ERROR_CHECK(esp_lcd_panel_set_gap(handles.panel_handle, 52, 40));
-    ESP_ERROR_CHECK(esp_lcd_panel_disp_on_off(handles.panel_handle, true));
+    ESP_ERROR_CHECK(display_init_bus());
 
+    const size_t clock_count = sizeof(spi_clock_ladder_hz) / sizeof(spi_clock_ladder_hz[0]);
+    esp_err_t ret = ESP_ERR_NOT_SUPPORTED;
+    for (size_t i = 0; i < clock_count; i++) {
+        if (spi_clock_ladder_hz[i] > SPI_CLOCK_HZ) {
+            continue;
+        }
+
+        ret = display_create_panel(spi_clock_ladder_hz[i], &handles);
+        if (ret == ESP_OK) {
+            break;
+        }
+        ESP_LOGW(TAG,
+            "Panel init at %lu MHz failed (%s), retrying lower",
+            (unsigned long)(spi_clock_ladder_hz[i] / 1000000U),
+            esp_err_to_name(ret));
+    }
+    ESP_ERROR_CHECK(ret);
+
+    ESP_LOGI(TAG,
+        "ST7789 up at %lu MHz (queue=%d, draw buffer=1/%d screen)",
+        (unsigned long)(handles.pclk_hz / 1000000U),
+        CONFIG_DISPLAY_SPI_TRANS_QUEUE_DEPTH,
+        CONFIG_DISPLAY_DRAW_BUFFER_DIVISOR);
+
+    s_sleep_out_us = esp_timer_get_time();
     return handles;
-}
\ No newline at end of file
+}
+
+esp_err_t display_sleep(display_handles_t* handles)
+{
+    if (!handles || !handles->io_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int64_t since_out_ms = (esp_timer_get_time() - s_sleep_out_us) / 1000;
+    if (since_out_ms < PANEL_SLEEP_OUT_TO_IN_MS) {
+        display_delay_ms((uint32_t)(PANEL_SLEEP_OUT_TO_IN_MS - since_out_ms));
+    }
+
+    /* Parameter writes wait for queued color transactions, so no flush is cut short. */
+    esp_err_t ret = esp_lcd_panel_io_tx_param(handles->io_handle, LCD_CMD_DISPOFF, NULL, 0);
+    if (ret == ESP_OK) {
+        ret = esp_lcd_panel_io_tx_param(handles->io_handle, LCD_CMD_SLPIN, NULL, 0);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Panel sleep failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    display_delay_ms(PANEL_SLEEP_SETTLE_MS);
+
+#if CONFIG_DISPLAY_SLEEP_RELEASE_BUS
+    uint32_t pclk_hz = handles->pclk_hz;
+    display_delete_panel(handles);
+    handles->pclk_hz = pclk_hz;
+
+    ret = spi_bus_free(LCD_HOST);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "SPI bus release failed: %s", esp_err_to_name(ret));
+    }
+    s_bus_released = true;
+
+    /* Park the bus pins on pull-ups so a floating CS cannot clock noise into the panel. */
+    gpio_reset_pin(PIN_NUM_CS);
+    gpio_reset_pin(PIN_NUM_DC);
+    gpio_reset_pin(PIN_NUM_SCLK);
+    gpio_reset_pin(PIN_NUM_MOSI);
+#endif
+
+    return ESP_OK;
+}
+
+esp_err_t display_wake(display_handles_t* handles, bool* out_ram_lost)
+{
+    if (!handles) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (out_ram_lost) {
+        *out_ram_lost = false;
+    }
+
+    esp_err_t ret;
+    if (s_bus_released) {
+        ret = display_init_bus();
+        if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+            ESP_LOGE(TAG, "SPI bus init on wake failed: %s", esp_err_to_name(ret));
+            return ret;
+        }
+        s_bus_released = false;
+
+        /* New panel objects reset the controller, so frame memory has to be redrawn. */
+        ret = display_create_panel(handles->pclk_hz, handles);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Panel re-init on wake failed: %s", esp_err_to_name(ret));
+            return ret;
+        }
+        if (out_ram_lost) {
+            *out_ram_lost = true;
+        }
+        s_sleep_out_us = esp_timer_get_time();
+        return ESP_OK;
+    }
+
+    if (!handles->io_handle) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    ret = esp_lcd_panel_io_tx_param(handles->io_handle, LCD_CMD_SLPOUT, NULL, 0);
+    if (ret == ESP_OK) {
+        s_sleep_out_us = esp_timer_get_time();
+        display_delay_ms(PANEL_SLEEP_SETTLE_MS);
+        ret = esp_lcd_panel_io_tx_param(handles->io_handle, LCD_CMD_DISPON, NULL, 0);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Panel wake failed: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+static void display_wait_transfers(const display_handles_t* handles)
+{
+    /* A parameter write waits for every queued color transaction to finish. */
+    esp_lcd_panel_io_tx_param(handles->io_handle, LCD_CMD_NOP, NULL, 0);
+}
+
+esp_err_t display_draw_splash(const display_handles_t* handles, const uint8_t* img_bin, size_t img_bin_size, int x, int y)
+{
+    if (!handles || !handles->panel_handle || !img_bin || img_bin_size < SPLASH_HEADER_BYTES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t header = (uint32_t)img_bin[0] | ((uint32_t)img_bin[1] << 8) | ((uint32_t)img_bin[2] << 16) |
+                      ((uint32_t)img_bin[3] << 24);
+    uint32_t cf = header & 0x1FU;
+    int w = (int)((header >> 10) & 0x7FFU);
+    int h = (int)((header >> 21) & 0x7FFU);
+    if (cf != SPLASH_CF_TRUE_COLOR || w == 0 || h == 0 || w > SPLASH_CHUNK_PIXELS ||
+        img_bin_size < SPLASH_HEADER_BYTES + (size_t)w * (size_t)h * sizeof(uint16_t)) {
+        ESP_LOGW(TAG, "Splash image rejected (cf=%lu %dx%d)", (unsigned long)cf, w, h);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (x < 0 || y < 0 || x + w > WIDTH || y + h > HEIGHT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    /* The image may sit in flash; stage it through a small DMA buffer. */
+    uint16_t* buf = heap_caps_calloc(SPLASH_CHUNK_PIXELS, sizeof(uint16_t), MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    if (!buf) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    const int clear_lines = SPLASH_CHUNK_PIXELS / WIDTH;
+    for (int row = 0; row < HEIGHT; row += clear_lines) {
+        int row_end = (row + clear_lines > HEIGHT) ? HEIGHT : (row + clear_lines);
+        esp_lcd_panel_draw_bitmap(handles->panel_handle, 0, row, WIDTH, row_end, buf);
+    }
+
+    const uint8_t* pixels = img_bin + SPLASH_HEADER_BYTES;
+    const int chunk_rows = SPLASH_CHUNK_PIXELS / w;
+    for (int row = 0; row < h; row += chunk_rows) {
+        int rows = (row + chunk_rows > h) ? (h - row) : chunk_rows;
+        size_t bytes = (size_t)w * (size_t)rows * sizeof(uint16_t);
+
+        display_wait_transfers(handles);
+        memcpy(buf, pixels + (size_t)row * (size_t)w * sizeof(uint16_t), bytes);
+        esp_lcd_panel_draw_bitmap(handles->panel_handle, x, y + row, x + w, y + row + rows, buf);
+    }
+
+    display_wait_transfers(handles);
+    heap_caps_free(buf);
+    return ESP_OK;
+}
+
+#if CONFIG_DISPLAY_FLUSH_BENCHMARK
+static int64_t display_bench_frames(const display_handles_t* handles, const uint16_t* buf, int lines)
+{
+    int64_t start_us = esp_timer_get_time();
+    for (int frame = 0; frame < FLUSH_BENCH_FRAMES; frame++) {
+        for (int y = 0; y < HEIGHT; y += lines) {
+            int y_end = (y + lines > HEIGHT) ? HEIGHT : (y + lines);
+            esp_lcd_panel_draw_bitmap(handles->panel_handle, 0, y, WIDTH, y_end, buf);
+        }
+    }
+
+    display_wait_transfers(handles);
+    return esp_timer_get_time() - start_us;
+}
+
+void display_run_flush_benchmark(display_handles_t* handles)
+{
+    static const int divisors[] = {1, 2, 4, 10};
+    const size_t divisor_count = sizeof(divisors) / sizeof(divisors[0]);
+    const size_t clock_count = sizeof(spi_clock_ladder_hz) / sizeof(spi_clock_ladder_hz[0]);
+    const size_t frame_bytes = WIDTH * HEIGHT * sizeof(uint16_t);
+
+    if (!handles) {
+        return;
+    }
+
+    uint16_t* buf = heap_caps_calloc(1, frame_bytes, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    if (!buf) {
+        ESP_LOGW(TAG, "Flush benchmark skipped: no DMA memory for %u bytes", (unsigned int)frame_bytes);
+        return;
+    }
+
+    uint32_t selected_hz = handles->pclk_hz;
+    for (size_t c = 0; c < clock_count; c++) {
+        display_delete_panel(handles);
+        esp_err_t ret = display_create_panel(spi_clock_ladder_hz[c], handles);
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG,
+                "bench clk=%lu MHz: panel init failed (%s)",
+                (unsigned long)(spi_clock_ladder_hz[c] / 1000000U),
+                esp_err_to_name(ret));
+            continue;
+        }
+
+        for (size_t d = 0; d < divisor_count; d++) {
+            int lines = HEIGHT / divisors[d];
+            int64_t total_us = display_bench_frames(handles, buf, lines);
+            if (total_us <= 0) {
+                continue;
+            }
+
+            float frame_ms = (float)total_us / (float)FLUSH_BENCH_FRAMES / 1000.0f;
+            float mb_per_s = (float)(frame_bytes * FLUSH_BENCH_FRAMES) / (float)total_us;
+            ESP_LOGI(TAG,
+                "bench clk=%lu MHz queue=%d buffer=1/%d: frame=%.2f ms, %.2f MB/s",
+                (unsigned long)(spi_clock_ladder_hz[c] / 1000000U),
+                CONFIG_DISPLAY_SPI_TRANS_QUEUE_DEPTH,
+                divisors[d],
+                frame_ms,
+                mb_per_s);
+        }
+    }
+
+    heap_caps_free(buf);
+
+    display_delete_panel(handles);
+    ESP_ERROR_CHECK(display_create_panel(selected_hz, handles));
+}
+#else
+void display_run_flush_benchmark(display_handles_t* handles)
+{
+    (void)handles;
+}
+#endif
@@ -0,0 +1,686 @@
+#include "display_lvgl.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_heap_caps.h"
+#include "esp_lcd_panel_commands.h"
+#include "esp_log.h"
+#include "esp_lvgl_port.h"
+#include "esp_pm.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+static const char* TAG = "display_lvgl";
+
+#define DISPLAY_STATS_LOG_PERIOD_MS 10000
+#define DISPLAY_LATENCY_PENDING_MAX 4
+#define DISPLAY_LATENCY_MAX_AGE_US (10LL * 1000000LL)
+#define DISPLAY_LATENCY_STUCK_FRAMES 8U
+
+const uint16_t display_latency_bucket_ms[DISPLAY_LATENCY_BUCKETS - 1] = {16, 33, 50, 100, 200, 300, 500, 1000, 2000};
+
+typedef struct {
+    int64_t origin_us;
+    int64_t queued_us;
+    int64_t applied_us;
+} display_latency_mark_t;
+
+typedef struct {
+    display_latency_mark_t marks[DISPLAY_LATENCY_PENDING_MAX];
+    uint8_t count;
+} display_latency_queue_t;
+
+typedef struct {
+    esp_lcd_panel_io_handle_t io_handle;
+    esp_lcd_panel_handle_t panel_handle;
+    lv_disp_t* disp;
+    lv_timer_cb_t refr_timer_cb;
+    uint32_t pending_flushes;
+    int64_t flush_start_us;
+    bool flush_is_last;
+    uint32_t flush_frame;
+    uint32_t frame;
+    bool asleep;
+    size_t draw_buf_pixels;
+    bool draw_buf_double;
+    /* CPU held at the ceiling for the render burst; the SPI driver holds APB for the transfers. */
+    esp_pm_lock_handle_t pm_lock;
+    display_lvgl_stats_t stats;
+#if CONFIG_DISPLAY_LATENCY_TRACE
+    /* Marks wait in pending until a refresh picks them up, then stay in
+     * flight until the last transfer of that refresh is done. */
+    display_latency_queue_t pending[DISPLAY_LATENCY_SOURCE_COUNT];
+    display_latency_queue_t inflight[DISPLAY_LATENCY_SOURCE_COUNT];
+    bool inflight_valid;
+    uint32_t inflight_frame;
+    display_latency_hist_t latency[DISPLAY_LATENCY_SOURCE_COUNT];
+#endif
+} display_lvgl_ctx_t;
+
+static display_lvgl_ctx_t s_ctx;
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+#if CONFIG_DISPLAY_LATENCY_TRACE
+static const char* const latency_source_names[DISPLAY_LATENCY_SOURCE_COUNT] = {"sample", "press"};
+
+/* Both helpers run with s_stats_lock held. */
+static void display_lvgl_latency_record(display_latency_hist_t* hist, const display_latency_mark_t* mark, int64_t now_us)
+{
+    uint32_t total_us = (uint32_t)(now_us - mark->origin_us);
+    uint32_t total_ms = total_us / 1000U;
+
+    size_t bucket = 0;
+    while (bucket < (DISPLAY_LATENCY_BUCKETS - 1) && total_ms >= display_latency_bucket_ms[bucket]) {
+        bucket++;
+    }
+
+    hist->buckets[bucket]++;
+    hist->count++;
+    hist->total_us += total_us;
+    if (total_us > hist->max_us) {
+        hist->max_us = total_us;
+    }
+    hist->origin_to_queued_us += (uint64_t)(mark->queued_us - mark->origin_us);
+    hist->queued_to_applied_us += (uint64_t)(mark->applied_us - mark->queued_us);
+    hist->applied_to_flushed_us += (uint64_t)(now_us - mark->applied_us);
+}
+
+static void display_lvgl_latency_complete(uint32_t frame, int64_t now_us)
+{
+    if (!s_ctx.inflight_valid || s_ctx.inflight_frame != frame) {
+        return;
+    }
+
+    for (int src = 0; src < DISPLAY_LATENCY_SOURCE_COUNT; src++) {
+        display_latency_queue_t* queue = &s_ctx.inflight[src];
+        for (uint8_t i = 0; i < queue->count; i++) {
+            display_lvgl_latency_record(&s_ctx.latency[src], &queue->marks[i], now_us);
+        }
+        queue->count = 0;
+    }
+    s_ctx.inflight_valid = false;
+}
+
+static void display_lvgl_latency_frame_begin(void)
+{
+    int64_t now_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_stats_lock);
+    s_ctx.frame++;
+    if (s_ctx.inflight_valid && (s_ctx.frame - s_ctx.inflight_frame) > DISPLAY_LATENCY_STUCK_FRAMES) {
+        /* The frame's last transfer never completed; give up on its marks. */
+        for (int src = 0; src < DISPLAY_LATENCY_SOURCE_COUNT; src++) {
+            s_ctx.latency[src].expired += s_ctx.inflight[src].count;
+            s_ctx.inflight[src].count = 0;
+        }
+        s_ctx.inflight_valid = false;
+    }
+    if (!s_ctx.inflight_valid) {
+        bool any = false;
+        for (int src = 0; src < DISPLAY_LATENCY_SOURCE_COUNT; src++) {
+            display_latency_queue_t* pending = &s_ctx.pending[src];
+            display_latency_queue_t* inflight = &s_ctx.inflight[src];
+            inflight->count = 0;
+            for (uint8_t i = 0; i < pending->count; i++) {
+                if ((now_us - pending->marks[i].origin_us) > DISPLAY_LATENCY_MAX_AGE_US) {
+                    s_ctx.latency[src].expired++;
+                    continue;
+                }
+                inflight->marks[inflight->count++] = pending->marks[i];
+            }
+            pending->count = 0;
+            any = any || (inflight->count > 0U);
+        }
+        s_ctx.inflight_valid = any;
+        s_ctx.inflight_frame = s_ctx.frame;
+    }
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+
+static void display_lvgl_latency_frame_end(bool flushed)
+{
+    portENTER_CRITICAL(&s_stats_lock);
+    if (!flushed && s_ctx.inflight_valid && s_ctx.inflight_frame == s_ctx.frame) {
+        /* Nothing reached the panel: the marks wait for the next refresh. */
+        for (int src = 0; src < DISPLAY_LATENCY_SOURCE_COUNT; src++) {
+            s_ctx.pending[src] = s_ctx.inflight[src];
+            s_ctx.inflight[src].count = 0;
+        }
+        s_ctx.inflight_valid = false;
+    }
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+#endif
+
+static bool display_lvgl_on_flush_done(
+    esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t* edata, void* user_ctx)
+{
+    (void)panel_io;
+    (void)edata;
+    lv_disp_drv_t* drv = (lv_disp_drv_t*)user_ctx;
+
+    portENTER_CRITICAL_ISR(&s_stats_lock);
+    bool last = (s_ctx.pending_flushes <= 1U);
+    if (s_ctx.pending_flushes > 0U) {
+        s_ctx.pending_flushes--;
+    }
+    if (last) {
+        int64_t now_us = esp_timer_get_time();
+        s_ctx.stats.flush_us += (uint64_t)(now_us - s_ctx.flush_start_us);
+#if CONFIG_DISPLAY_LATENCY_TRACE
+        if (s_ctx.flush_is_last) {
+            display_lvgl_latency_complete(s_ctx.flush_frame, now_us);
+        }
+#endif
+    }
+    portEXIT_CRITICAL_ISR(&s_stats_lock);
+
+    if (last) {
+        lv_disp_flush_ready(drv);
+    }
+    return false;
+}
+
+static void display_lvgl_begin_flush(uint32_t transfers, uint32_t pixels, bool last_of_frame)
+{
+    portENTER_CRITICAL(&s_stats_lock);
+    s_ctx.pending_flushes = transfers;
+    s_ctx.flush_start_us = esp_timer_get_time();
+    s_ctx.flush_is_last = last_of_frame;
+    s_ctx.flush_frame = s_ctx.frame;
+    s_ctx.stats.flushed_px += pixels;
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+
+static void display_lvgl_flush_partial(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_map)
+{
+    display_lvgl_begin_flush(1U, (uint32_t)lv_area_get_size(area), lv_disp_flush_is_last(drv));
+    esp_lcd_panel_draw_bitmap(s_ctx.panel_handle, area->x1, area->y1, area->x2 + 1, area->y2 + 1, color_map);
+}
+
+static void display_lvgl_flush_direct(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_map)
+{
+    (void)area;
+
+    /* The frame buffer already holds every area; push once the last one is rendered. */
+    if (!lv_disp_flush_is_last(drv)) {
+        lv_disp_flush_ready(drv);
+        return;
+    }
+
+    lv_disp_t* disp = _lv_refr_get_disp_refreshing();
+    lv_coord_t band_y1[LV_INV_BUF_SIZE];
+    lv_coord_t band_y2[LV_INV_BUF_SIZE];
+    uint32_t band_count = 0;
+
+    /* Collect dirty row bands sorted by start row. */
+    for (uint16_t i = 0; disp && i < disp->inv_p; i++) {
+        if (disp->inv_area_joined[i]) {
+            continue;
+        }
+
+        lv_coord_t y1 = disp->inv_areas[i].y1;
+        lv_coord_t y2 = disp->inv_areas[i].y2;
+        uint32_t pos = band_count;
+        while (pos > 0 && band_y1[pos - 1] > y1) {
+            band_y1[pos] = band_y1[pos - 1];
+            band_y2[pos] = band_y2[pos - 1];
+            pos--;
+        }
+        band_y1[pos] = y1;
+        band_y2[pos] = y2;
+        band_count++;
+    }
+
+    /* Merge overlapping or touching bands. */
+    uint32_t merged = 0;
+    for (uint32_t i = 0; i < band_count; i++) {
+        if (merged > 0 && band_y1[i] <= band_y2[merged - 1] + 1) {
+            if (band_y2[i] > band_y2[merged - 1]) {
+                band_y2[merged - 1] = band_y2[i];
+            }
+            continue;
+        }
+        band_y1[merged] = band_y1[i];
+        band_y2[merged] = band_y2[i];
+        merged++;
+    }
+
+    if (merged == 0) {
+        lv_disp_flush_ready(drv);
+        return;
+    }
+
+    /* Full-width rows are contiguous in the frame buffer, so each band is a single transfer. */
+    lv_coord_t hor_res = drv->hor_res;
+    uint32_t pixels = 0;
+    for (uint32_t i = 0; i < merged; i++) {
+        pixels += (uint32_t)hor_res * (uint32_t)(band_y2[i] - band_y1[i] + 1);
+    }
+
+    display_lvgl_begin_flush(merged, pixels, true);
+    for (uint32_t i = 0; i < merged; i++) {
+        esp_lcd_panel_draw_bitmap(s_ctx.panel_handle,
+            0,
+            band_y1[i],
+            hor_res,
+            band_y2[i] + 1,
+            color_map + ((size_t)band_y1[i] * (size_t)hor_res));
+    }
+}
+
+static void display_lvgl_refr_timer_cb(lv_timer_t* timer)
+{
+    uint64_t px_before = s_ctx.stats.flushed_px;
+    if (s_ctx.pm_lock) {
+        esp_pm_lock_acquire(s_ctx.pm_lock);
+    }
+    int64_t start_us = esp_timer_get_time();
+#if CONFIG_DISPLAY_LATENCY_TRACE
+    display_lvgl_latency_frame_begin();
+#else
+    s_ctx.frame++;
+#endif
+
+    s_ctx.refr_timer_cb(timer);
+
+    int64_t elapsed_us = esp_timer_get_time() - start_us;
+    if (s_ctx.pm_lock) {
+        esp_pm_lock_release(s_ctx.pm_lock);
+    }
+    bool flushed = false;
+    portENTER_CRITICAL(&s_stats_lock);
+    if (s_ctx.stats.flushed_px != px_before) {
+        flushed = true;
+        s_ctx.stats.frames++;
+        s_ctx.stats.refresh_us += (uint64_t)elapsed_us;
+    }
+    portEXIT_CRITICAL(&s_stats_lock);
+
+#if CONFIG_DISPLAY_LATENCY_TRACE
+    display_lvgl_latency_frame_end(flushed);
+#else
+    (void)flushed;
+#endif
+}
+
+#if CONFIG_DISPLAY_RENDER_STATS
+static void display_lvgl_stats_timer_cb(lv_timer_t* timer)
+{
+    (void)timer;
+
+    display_lvgl_stats_t stats = {0};
+    display_lvgl_get_stats(&stats, true);
+    if (stats.frames == 0U) {
+        return;
+    }
+
+    ESP_LOGI(TAG,
+        "%s: frames=%lu refresh=%.2f ms flush=%.2f ms px/frame=%lu draw_buf=%u B free_internal=%u B",
+        s_ctx.disp->driver->direct_mode ? "direct" : "partial",
+        (unsigned long)stats.frames,
+        (double)stats.refresh_us / (double)stats.frames / 1000.0,
+        (double)stats.flush_us / (double)stats.frames / 1000.0,
+        (unsigned long)(stats.flushed_px / stats.frames),
+        (unsigned int)stats.draw_buf_bytes,
+        (unsigned int)heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+}
+#endif
+
+lv_disp_t* display_lvgl_add(const display_handles_t* handles)
+{
+    if (!handles) {
+        return NULL;
+    }
+
+#if CONFIG_DISPLAY_RENDER_MODE_DIRECT
+    const bool direct_mode = true;
+#else
+    const bool direct_mode = false;
+#endif
+
+    const lvgl_port_display_cfg_t disp_cfg = {
+        .io_handle = handles->io_handle,
+        .panel_handle = handles->panel_handle,
+        .buffer_size = direct_mode ? (WIDTH * HEIGHT) : DISPLAY_DRAW_BUFFER_PIXELS,
+        .double_buffer = !direct_mode,
+        .hres = WIDTH,
+        .vres = HEIGHT,
+        .monochrome = false,
+        .rotation =
+            {
+                .swap_xy = false,
+                .mirror_x = false,
+                .mirror_y = false,
+            },
+        .flags =
+            {
+                .buff_dma = true,
+                .buff_spiram = false,
+                .full_refresh = false,
+            },
+    };
+
+    lv_disp_t* disp = lvgl_port_add_disp(&disp_cfg);
+    if (!disp) {
+        ESP_LOGE(TAG, "Failed to add LVGL display");
+        return NULL;
+    }
+
+    lvgl_port_lock(0);
+
+    memset(&s_ctx, 0, sizeof(s_ctx));
+    s_ctx.io_handle = handles->io_handle;
+    s_ctx.panel_handle = handles->panel_handle;
+    s_ctx.disp = disp;
+
+    /* Take over the flush path so both modes share flush-done accounting. */
+    disp->driver->direct_mode = direct_mode ? 1 : 0;
+    disp->driver->flush_cb = direct_mode ? display_lvgl_flush_direct : display_lvgl_flush_partial;
+    const esp_lcd_panel_io_callbacks_t cbs = {
+        .on_color_trans_done = display_lvgl_on_flush_done,
+    };
+    esp_lcd_panel_io_register_event_callbacks(handles->io_handle, &cbs, disp->driver);
+
+    s_ctx.refr_timer_cb = disp->refr_timer->timer_cb;
+    disp->refr_timer->timer_cb = display_lvgl_refr_timer_cb;
+    if (esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "lvgl_refr", &s_ctx.pm_lock) != ESP_OK) {
+        s_ctx.pm_lock = NULL;
+    }
+
+    const lv_disp_draw_buf_t* draw_buf = disp->driver->draw_buf;
+    s_ctx.draw_buf_pixels = draw_buf->size;
+    s_ctx.draw_buf_double = (draw_buf->buf2 != NULL);
+    s_ctx.stats.draw_buf_bytes = s_ctx.draw_buf_pixels * sizeof(lv_color_t) * (s_ctx.draw_buf_double ? 2U : 1U);
+
+#if CONFIG_DISPLAY_RENDER_STATS
+    lv_timer_create(display_lvgl_stats_timer_cb, DISPLAY_STATS_LOG_PERIOD_MS, NULL);
+#endif
+
+    lvgl_port_unlock();
+
+    ESP_LOGI(TAG,
+        "LVGL display in %s mode (draw buffers %u B)",
+        direct_mode ? "direct" : "partial",
+        (unsigned int)s_ctx.stats.draw_buf_bytes);
+
+    return disp;
+}
+
+#if CONFIG_DISPLAY_SLEEP_FREE_DRAW_BUFFERS
+static void display_lvgl_free_draw_buffers(void)
+{
+    lv_disp_draw_buf_t* draw_buf = s_ctx.disp->driver->draw_buf;
+    heap_caps_free(draw_buf->buf1);
+    heap_caps_free(draw_buf->buf2);
+    draw_buf->buf1 = NULL;
+    draw_buf->buf2 = NULL;
+    draw_buf->buf_act = NULL;
+
+    portENTER_CRITICAL(&s_stats_lock);
+    s_ctx.stats.draw_buf_bytes = 0;
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+
+static esp_err_t display_lvgl_alloc_draw_buffers(void)
+{
+    lv_disp_draw_buf_t* draw_buf = s_ctx.disp->driver->draw_buf;
+    if (draw_buf->buf1) {
+        return ESP_OK;
+    }
+
+    const size_t bytes = s_ctx.draw_buf_pixels * sizeof(lv_color_t);
+    void* buf1 = heap_caps_malloc(bytes, MALLOC_CAP_DMA);
+    void* buf2 = s_ctx.draw_buf_double ? heap_caps_malloc(bytes, MALLOC_CAP_DMA) : NULL;
+    if (!buf1 || (s_ctx.draw_buf_double && !buf2)) {
+        heap_caps_free(buf1);
+        heap_caps_free(buf2);
+        ESP_LOGE(TAG, "No DMA memory to restore draw buffers (%u B each)", (unsigned int)bytes);
+        return ESP_ERR_NO_MEM;
+    }
+
+    lv_disp_draw_buf_init(draw_buf, buf1, buf2, (uint32_t)s_ctx.draw_buf_pixels);
+
+    portENTER_CRITICAL(&s_stats_lock);
+    s_ctx.stats.draw_buf_bytes = bytes * (s_ctx.draw_buf_double ? 2U : 1U);
+    portEXIT_CRITICAL(&s_stats_lock);
+    return ESP_OK;
+}
+#endif
+
+esp_err_t display_lvgl_sleep(display_handles_t* handles)
+{
+    if (!handles || !s_ctx.disp) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    lvgl_port_lock(0);
+    if (s_ctx.asleep) {
+        lvgl_port_unlock();
+        return ESP_OK;
+    }
+
+    /* Nothing may render into the draw buffers or touch the bus until wake. */
+    lv_timer_pause(s_ctx.disp->refr_timer);
+
+    esp_err_t ret = display_sleep(handles);
+    if (ret != ESP_OK) {
+        lv_timer_resume(s_ctx.disp->refr_timer);
+        lvgl_port_unlock();
+        return ret;
+    }
+
+#if CONFIG_DISPLAY_SLEEP_FREE_DRAW_BUFFERS
+    display_lvgl_free_draw_buffers();
+#endif
+
+    s_ctx.asleep = true;
+    lvgl_port_unlock();
+
+    ESP_LOGI(TAG, "Display asleep (free internal %u B)", (unsigned int)heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+    return ESP_OK;
+}
+
+esp_err_t display_lvgl_wake(display_handles_t* handles)
+{
+    if (!handles || !s_ctx.disp) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    lvgl_port_lock(0);
+    if (!s_ctx.asleep) {
+        lvgl_port_unlock();
+        return ESP_OK;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    bool ram_lost = false;
+    esp_err_t ret = display_wake(handles, &ram_lost);
+    if (ret != ESP_OK) {
+        lvgl_port_unlock();
+        return ret;
+    }
+
+    bool redraw = ram_lost;
+    if (handles->panel_handle != s_ctx.panel_handle) {
+        /* The panel IO was recreated: move the flush path over to it. */
+        s_ctx.io_handle = handles->io_handle;
+        s_ctx.panel_handle = handles->panel_handle;
+        const esp_lcd_panel_io_callbacks_t cbs = {
+            .on_color_trans_done = display_lvgl_on_flush_done,
+        };
+        esp_lcd_panel_io_register_event_callbacks(handles->io_handle, &cbs, s_ctx.disp->driver);
+        portENTER_CRITICAL(&s_stats_lock);
+        s_ctx.pending_flushes = 0;
+        portEXIT_CRITICAL(&s_stats_lock);
+    }
+
+#if CONFIG_DISPLAY_SLEEP_FREE_DRAW_BUFFERS
+    ret = display_lvgl_alloc_draw_buffers();
+    if (ret != ESP_OK) {
+        /* Panel is up but LVGL cannot render; stay paused and let the caller retry. */
+        lvgl_port_unlock();
+        return ret;
+    }
+    /* A direct-mode frame buffer must hold the whole frame again. */
+    redraw = redraw || s_ctx.disp->driver->direct_mode;
+#endif
+
+    if (redraw) {
+        lv_obj_invalidate(lv_disp_get_scr_act(s_ctx.disp));
+    }
+    s_ctx.asleep = false;
+    lv_timer_resume(s_ctx.disp->refr_timer);
+    lv_timer_ready(s_ctx.disp->refr_timer);
+    lvgl_port_unlock();
+
+    ESP_LOGI(TAG,
+        "Display awake in %lu us%s",
+        (unsigned long)(esp_timer_get_time() - start_us),
+        redraw ? " (full redraw pending)" : "");
+    return ESP_OK;
+}
+
+uint32_t display_lvgl_render_now(void)
+{
+    lvgl_port_lock(0);
+    if (!s_ctx.disp || s_ctx.asleep) {
+        lvgl_port_unlock();
+        return 0;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+
+    /* Same as lv_refr_now(), but through the wrapper so stats and latency marks see the frame. */
+    lv_anim_refr_now();
+    display_lvgl_refr_timer_cb(s_ctx.disp->refr_timer);
+
+    /* A parameter write waits for every queued color transaction to finish. */
+    esp_lcd_panel_io_tx_param(s_ctx.io_handle, LCD_CMD_NOP, NULL, 0);
+
+    uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - start_us);
+    lvgl_port_unlock();
+    return elapsed_us;
+}
+
+bool display_lvgl_is_asleep(void)
+{
+    return s_ctx.asleep;
+}
+
+void display_lvgl_get_stats(display_lvgl_stats_t* out_stats, bool reset)
+{
+    if (!out_stats) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_stats_lock);
+    *out_stats = s_ctx.stats;
+    if (reset) {
+        s_ctx.stats.frames = 0;
+        s_ctx.stats.refresh_us = 0;
+        s_ctx.stats.flush_us = 0;
+        s_ctx.stats.flushed_px = 0;
+    }
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+
+void display_lvgl_trace_latency(display_latency_source_t source, int64_t origin_us, int64_t queued_us)
+{
+#if CONFIG_DISPLAY_LATENCY_TRACE
+    if (source >= DISPLAY_LATENCY_SOURCE_COUNT || !s_ctx.disp || s_ctx.disp->inv_p == 0U) {
+        return;
+    }
+
+    const display_latency_mark_t mark = {
+        .origin_us = origin_us,
+        .queued_us = queued_us,
+        .applied_us = esp_timer_get_time(),
+    };
+
+    portENTER_CRITICAL(&s_stats_lock);
+    display_latency_queue_t* queue = &s_ctx.pending[source];
+    if (queue->count == DISPLAY_LATENCY_PENDING_MAX) {
+        memmove(&queue->marks[0], &queue->marks[1], sizeof(queue->marks[0]) * (DISPLAY_LATENCY_PENDING_MAX - 1));
+        queue->count--;
+        s_ctx.latency[source].expired++;
+    }
+    queue->marks[queue->count++] = mark;
+    portEXIT_CRITICAL(&s_stats_lock);
+#else
+    (void)source;
+    (void)origin_us;
+    (void)queued_us;
+#endif
+}
+
+void display_lvgl_get_latency(display_latency_source_t source, display_latency_hist_t* out_hist, bool reset)
+{
+    if (!out_hist) {
+        return;
+    }
+
+    memset(out_hist, 0, sizeof(*out_hist));
+#if CONFIG_DISPLAY_LATENCY_TRACE
+    if (source >= DISPLAY_LATENCY_SOURCE_COUNT) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_stats_lock);
+    *out_hist = s_ctx.latency[source];
+    if (reset) {
+        memset(&s_ctx.latency[source], 0, sizeof(s_ctx.latency[source]));
+    }
+    portEXIT_CRITICAL(&s_stats_lock);
+#else
+    (void)source;
+    (void)reset;
+#endif
+}
+
+void display_lvgl_log_latency(bool reset)
+{
+#if CONFIG_DISPLAY_LATENCY_TRACE
+    for (int src = 0; src < DISPLAY_LATENCY_SOURCE_COUNT; src++) {
+        display_latency_hist_t hist;
+        display_lvgl_get_latency((display_latency_source_t)src, &hist, reset);
+        if (hist.count == 0U) {
+            ESP_LOGI(TAG, "latency %s: no events (expired=%lu)", latency_source_names[src], (unsigned long)hist.expired);
+            continue;
+        }
+
+        char buckets[128];
+        size_t len = 0;
+        for (int b = 0; b < DISPLAY_LATENCY_BUCKETS && len < sizeof(buckets); b++) {
+            if (b < DISPLAY_LATENCY_BUCKETS - 1) {
+                len += (size_t)snprintf(&buckets[len],
+                    sizeof(buckets) - len,
+                    " <%u:%lu",
+                    (unsigned int)display_latency_bucket_ms[b],
+                    (unsigned long)hist.buckets[b]);
+            } else {
+                len += (size_t)snprintf(&buckets[len],
+                    sizeof(buckets) - len,
+                    " >=%u:%lu",
+                    (unsigned int)display_latency_bucket_ms[b - 1],
+                    (unsigned long)hist.buckets[b]);
+            }
+        }
+
+        ESP_LOGI(TAG,
+            "latency %s: n=%lu avg=%.1f ms max=%.1f ms (origin->queued %.1f, queued->ui %.1f, ui->glass %.1f ms) "
+            "expired=%lu",
+            latency_source_names[src],
+            (unsigned long)hist.count,
+            (double)hist.total_us / (double)hist.count / 1000.0,
+            (double)hist.max_us / 1000.0,
+            (double)hist.origin_to_queued_us / (double)hist.count / 1000.0,
+            (double)hist.queued_to_applied_us / (double)hist.count / 1000.0,
+            (double)hist.applied_to_flushed_us / (double)hist.count / 1000.0,
+            (unsigned long)hist.expired);
+        ESP_LOGI(TAG, "latency %s ms buckets:%s", latency_source_names[src], buckets);
+    }
+#else
+    (void)reset;
+    ESP_LOGI(TAG, "Latency tracing disabled (CONFIG_DISPLAY_LATENCY_TRACE)");
+#endif
+}
@@ -2,9 +2,10 @@
 
 #include <stdbool.h>
 #include <stdint.h>
-#include "esp_lcd_panel_ops.h"
 #include "esp_err.h"
 #include "backlight.h"
+#include "display.h"
+#include "sdkconfig.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -14,10 +15,16 @@ extern "C" {
  * @brief Power manager dependencies.
  */
 typedef struct {
-    /**< LCD panel handle used for display power transitions. */
-    esp_lcd_panel_handle_t panel_handle;
+    /**< Display handles used for panel sleep/wake; updated in place if the panel is recreated. */
+    display_handles_t* display;
     /**< Backlight handle used for brightness and display off/on. */
     backlight_handle_t* bl_handle;
+    /**< Optional, called with the LVGL lock held before the wake frame and before each
+     *   ambient glance update is rendered; bring the UI up to date with the latest data here. */
+    void (*on_display_refresh)(void);
+    /**< Optional, called right before every deep sleep (shutdown, idle ladder, deep monitoring);
+     *   store state for a fast resume in RTC memory here. Must not block. */
+    void (*on_deep_sleep)(void);
 } power_manager_config_t;
 
 /**
@@ -26,7 +33,7 @@ typedef struct {
 typedef struct {
     /**< Battery level in percent, -1 when unknown/invalid. */
     int percent;
-    /**< Heuristic charging state inferred from voltage trend. */
+    /**< Charging state inferred from the voltage slope (see power_manager_read_battery()). */
     bool charging;
     /**< Filtered battery voltage in millivolts. */
     uint16_t voltage_mv;
@@ -34,6 +41,31 @@ typedef struct {
     bool valid;
 } power_battery_info_t;
 
+/**
+ * @brief Idle ladder stages, in the order they are reached.
+ */
+typedef enum {
+    POWER_IDLE_STAGE_ACTIVE = 0,
+    POWER_IDLE_STAGE_DIM,
+    POWER_IDLE_STAGE_DISPLAY_OFF,
+    POWER_IDLE_STAGE_DEEP_SLEEP,
+    POWER_IDLE_STAGE_COUNT,
+} power_idle_stage_t;
+
+/**
+ * @brief Idle time after which each ladder stage is entered, in seconds.
+ *
+ * Non-zero values must increase from stage to stage; 0 skips the stage.
+ */
+typedef struct {
+    /**< Dim the backlight to CONFIG_PM_IDLE_DIM_PCT. */
+    uint32_t dim_s;
+    /**< Enter monitoring mode (see power_manager_enter_monitoring()). */
+    uint32_t display_off_s;
+    /**< Deep sleep with button wake only. */
+    uint32_t deep_sleep_s;
+} power_idle_thresholds_t;
+
 /**
  * @brief Initialize power manager runtime.
  *
@@ -48,14 +80,108 @@ void power_manager_shutdown(void);
 
 /**
  * @brief Enter low-power monitoring mode (display off, reduced activity).
+ *
+ * Fades the backlight out, then puts the panel into sleep mode and stops LVGL
+ * rendering (see display_lvgl_sleep()). With CONFIG_PM_AMBIENT_MODE the panel
+ * stays on instead, dimmed, with an IAQ/temperature glance that is redrawn every
+ * CONFIG_PM_AMBIENT_UPDATE_PERIOD_S while the LVGL port is stopped.
  */
 void power_manager_enter_monitoring(void);
 
 /**
  * @brief Exit monitoring mode and restore active display state.
+ *
+ * Wakes the panel with the backlight still off, lets on_display_refresh update the
+ * UI, renders and flushes one frame synchronously and only then fades the
+ * backlight in, so no stale values are ever lit. Logs the wake-to-first-correct-
+ * frame latency.
  */
 void power_manager_exit_monitoring(void);
 
+#if CONFIG_PM_DEEP_SLEEP_MONITORING
+/**
+ * @brief Deep-sleep until the next sensor sample is due, as the low-power form of monitoring.
+ *
+ * Powers the display down, suspends the BME680 with its BSEC context in RTC
+ * memory (see bme680_sensor_suspend()) and enables the timer and button wake
+ * sources. Does not return.
+ *
+ * @param[in] sleep_us Time until the next sample (at least 1 s is slept).
+ */
+void power_manager_enter_deep_monitoring(uint64_t sleep_us);
+
+/**
+ * @brief Check whether this boot is a timer wake from deep monitoring.
+ *
+ * Call early in app_main. On true, take one sample without the display and
+ * go back to sleep; any other boot (button wake, power-on) clears the
+ * deep monitoring state and should bring the full UI up.
+ *
+ * @return true for a monitoring timer wake.
+ */
+bool power_manager_is_deep_monitoring_wake(void);
+#endif
+
+/**
+ * @brief Step down the idle ladder for the given time without user input.
+ *
+ * Call periodically. Uses the battery or charging thresholds depending on the
+ * current charging state and only ever moves down the ladder: dim, display off
+ * (monitoring mode), then button-only deep sleep, which does not return. Time
+ * spent per stage is counted and kept in NVS.
+ *
+ * @param[in] idle_us Time since the last user input.
+ */
+void power_manager_process_idle(int64_t idle_us);
+
+/**
+ * @brief Return to full brightness with the display on after user input.
+ *
+ * Does nothing when the ladder is at POWER_IDLE_STAGE_ACTIVE. Call with the
+ * LVGL lock held.
+ */
+void power_manager_wake_from_idle(void);
+
+/**
+ * @brief Get the current idle ladder stage.
+ *
+ * @return Current stage; never POWER_IDLE_STAGE_DEEP_SLEEP for a running caller.
+ */
+power_idle_stage_t power_manager_get_idle_stage(void);
+
+/**
+ * @brief Get the idle ladder thresholds.
+ *
+ * @param[in] charging Thresholds used on the charger when true, on battery otherwise.
+ * @param[out] out_thresholds Output thresholds.
+ *
+ * @return
+ * - ESP_OK: thresholds copied.
+ * - ESP_ERR_INVALID_ARG: @p out_thresholds is NULL.
+ */
+esp_err_t power_manager_get_idle_thresholds(bool charging, power_idle_thresholds_t* out_thresholds);
+
+/**
+ * @brief Set the idle ladder thresholds and persist them in NVS.
+ *
+ * @param[in] charging Set the thresholds used on the charger when true, on battery otherwise.
+ * @param[in] thresholds New thresholds.
+ *
+ * @return
+ * - ESP_OK: thresholds updated.
+ * - ESP_ERR_INVALID_ARG: @p thresholds is NULL or its stages are out of order.
+ */
+esp_err_t power_manager_set_idle_thresholds(bool charging, const power_idle_thresholds_t* thresholds);
+
+/**
+ * @brief Get the total time spent in each idle ladder stage.
+ *
+ * Counts across reboots; deep sleep time is added after the next wake.
+ *
+ * @param[out] out_stage_s Seconds per stage, indexed by @ref power_idle_stage_t.
+ */
+void power_manager_get_idle_stats(uint64_t out_stage_s[POWER_IDLE_STAGE_COUNT]);
+
 /**
  * @brief Log wakeup reason from the last sleep cycle.
  */
@@ -64,10 +190,27 @@ void power_manager_check_wakeup_reason(void);
 /**
  * @brief Read battery state from ADC and infer charging trend.
  *
+ * Never blocks: the ADC is sampled in a timer-driven burst (median/MAD outlier
+ * rejection, mean of the rest). A call consumes the finished burst, or starts
+ * a new one and returns ESP_ERR_NOT_FINISHED; poll again a few ms later.
+ *
+ * The percent is taken from the open-circuit voltage: the estimated load
+ * (CPU clock, panel, backlight duty, sensor heater) times the battery internal
+ * resistance is added back, so a brief sag does not read as a drained cell.
+ * The voltage-to-percent curve is relearned over each full discharge and kept
+ * in NVS.
+ *
+ * Charging is detected from a least-squares slope of the load-compensated
+ * voltage with on/off hysteresis. A plug-sized step between readings starts a
+ * fast series of bursts 50 ms apart (ESP_ERR_NOT_FINISHED meanwhile), so the
+ * state usually flips within half a second of the next reading. A step whose
+ * level does not hold through the series is a load transient and is ignored.
+ *
  * @param[out] out_info Output battery information.
  *
  * @return
  * - ESP_OK: read completed (check @ref power_battery_info_t::valid).
+ * - ESP_ERR_NOT_FINISHED: a burst is in progress, @p out_info is not filled.
  * - ESP_ERR_INVALID_ARG: @p out_info is NULL.
  * - ESP_ERR_INVALID_STATE: battery ADC is not initialized.
  * - Other ESP error from GPIO/ADC operations.
@@ -102,6 +245,13 @@ esp_err_t power_manager_step_active_brightness(void);
  */
 uint8_t power_manager_get_active_brightness(void);
 
+/**
+ * @brief Report the gas sensor heater duty for the battery load model.
+ *
+ * @param[in] duty_permille Share of time the heater is on, in 1/1000 (clamped to 1000).
+ */
+void power_manager_set_heater_duty(uint16_t duty_permille);
+
 /**
  * @brief Check whether monitoring mode is active.
  *
@@ -13,7 +13,10 @@ void power_manager_init(const power_manager_config_t* config)
     s_pm_config = *config;
     pm_battery_init();
     pm_brightness_init();
+    pm_soc_init();
+    pm_idle_init();
     pm_brightness_apply_current();
+    pm_cpu_profile_update();
 }
 
 void power_manager_check_wakeup_reason(void)
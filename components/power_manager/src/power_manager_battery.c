@@ -1,4 +1,5 @@
 #include "power_manager_internal.h"
+#include "power_manager_charge.h"
 
 #include <string.h>
 
@@ -8,6 +9,8 @@
 #include "esp_adc/adc_oneshot.h"
 #include "esp_log.h"
 #include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
 
 static const char* TAG = "power_mgr";
 
@@ -16,26 +19,68 @@ static const char* TAG = "power_mgr";
 #define BATTERY_ADC_CHANNEL ADC_CHANNEL_6
 #define BATTERY_ADC_ATTEN ADC_ATTEN_DB_12
 #define BATTERY_DIVIDER_RATIO 2.0f
-#define BATTERY_FILTER_ALPHA 0.2f
-#define BATTERY_CHARGE_DELTA_MV 5.0f
-#define BATTERY_DISCHARGE_DELTA_MV -5.0f
-#define BATTERY_TREND_CONFIRM_SAMPLES 2U
+/* Each reading is already the mean of a burst, so the EMA only needs to smooth load steps. */
+#define BATTERY_FILTER_ALPHA 0.5f
+#define BATTERY_BURST_SAMPLES 16U
+#define BATTERY_BURST_PERIOD_US 500U
+/* Divider settle time after ADC_EN: measured at init, twice the observed time, within these bounds. */
+#define BATTERY_SETTLE_DEFAULT_US 2000U
+#define BATTERY_SETTLE_MIN_US 200U
+#define BATTERY_SETTLE_MAX_US 5000U
+#define BATTERY_SETTLE_PROBE_US 100U
+#define BATTERY_SETTLE_PROBE_SAMPLES 50U
+#define BATTERY_SETTLE_FINAL_SAMPLES 5U
+#define BATTERY_SETTLE_TOLERANCE_RAW 8
+/* Top + bottom resistor of the divider; it draws Vbat / R while enabled. */
+#define BATTERY_DIVIDER_TOTAL_OHMS 200000U
+/* Samples further than this many MADs from the median are dropped. */
+#define BATTERY_OUTLIER_MAD_K 3
+#define BATTERY_OUTLIER_MIN_RAW 8
+#define BATTERY_PERCENT_HYSTERESIS 2
 #define BATTERY_VALID_MIN_MV 2800
 #define BATTERY_VALID_MAX_MV 5200
 #define BATTERY_ADC_EN_AUTODETECT_MARGIN_MV 120
-#define BATTERY_CHARGING_ABS_ON_MV 4400
-#define BATTERY_CHARGING_ABS_OFF_MV 4250
 
 static adc_oneshot_unit_handle_t battery_adc_handle = NULL;
 static adc_cali_handle_t battery_cali_handle = NULL;
 static bool battery_cali_enabled = false;
 static bool battery_filter_valid = false;
 static float battery_filtered_mv = 0.0f;
-static float battery_prev_mv = 0.0f;
-static bool battery_charging = false;
-static uint8_t battery_charge_trend_count = 0;
-static uint8_t battery_discharge_trend_count = 0;
+/* Time of the last plug/unplug step, for the detection latency log; 0 when none pending. */
+static int64_t battery_step_us = 0;
 static int battery_adc_en_active_level = 1;
+static int battery_reported_pct = -1;
+static uint32_t battery_settle_us = BATTERY_SETTLE_DEFAULT_US;
+/* Settled reading with the divider held on at init, to check the gated path against. */
+static int battery_reference_raw = -1;
+
+typedef enum {
+    BATTERY_BURST_IDLE = 0,
+    BATTERY_BURST_RUNNING,
+    BATTERY_BURST_DONE,
+} battery_burst_state_t;
+
+typedef struct {
+    esp_timer_handle_t timer;
+    battery_burst_state_t state;
+    bool settling;
+    uint32_t count;
+    int raw[BATTERY_BURST_SAMPLES];
+    esp_err_t result;
+    int result_raw;
+    int64_t result_us;
+    uint32_t used;
+    /* Fast series: bursts left to run and the results collected so far. */
+    bool gap;
+    uint32_t fast_remaining;
+    uint32_t fast_count;
+    int fast_raw[BATTERY_FAST_BURSTS];
+    int64_t fast_us[BATTERY_FAST_BURSTS];
+} battery_burst_t;
+
+static battery_burst_t s_burst;
+static portMUX_TYPE s_burst_lock = portMUX_INITIALIZER_UNLOCKED;
+static pm_charge_detect_t s_charge;
 
 static esp_err_t battery_set_adc_enabled(bool enabled)
 {
@@ -43,33 +88,6 @@ static esp_err_t battery_set_adc_enabled(bool enabled)
     return gpio_set_level(BATTERY_ADC_EN_GPIO, level);
 }
 
-static int battery_percent_from_mv(int mv)
-{
-    static const int mv_points[] = {3200, 3400, 3500, 3600, 3700, 3800, 3900, 4000, 4100, 4200};
-    static const int pct_points[] = {0, 5, 10, 20, 35, 50, 65, 80, 92, 100};
-    const int points_count = (int)(sizeof(mv_points) / sizeof(mv_points[0]));
-
-    if (mv <= mv_points[0]) {
-        return pct_points[0];
-    }
-    if (mv >= mv_points[points_count - 1]) {
-        return pct_points[points_count - 1];
-    }
-
-    for (int i = 1; i < points_count; i++) {
-        if (mv <= mv_points[i]) {
-            int mv_low = mv_points[i - 1];
-            int mv_high = mv_points[i];
-            int pct_low = pct_points[i - 1];
-            int pct_high = pct_points[i];
-            int pct = pct_low + ((mv - mv_low) * (pct_high - pct_low)) / (mv_high - mv_low);
-            return pct;
-        }
-    }
-
-    return 100;
-}
-
 static bool battery_try_create_cali(
     adc_unit_t unit, adc_channel_t channel, adc_atten_t atten, adc_cali_handle_t* out_handle)
 {
@@ -99,18 +117,11 @@ static bool battery_try_create_cali(
     return false;
 }
 
-static void battery_reset_trend_counters(void)
-{
-    battery_charge_trend_count = 0;
-    battery_discharge_trend_count = 0;
-}
-
 static float battery_filter_apply(float batt_mv)
 {
     if (!battery_filter_valid) {
         battery_filter_valid = true;
         battery_filtered_mv = batt_mv;
-        battery_prev_mv = batt_mv;
     } else {
         battery_filtered_mv = battery_filtered_mv * (1.0f - BATTERY_FILTER_ALPHA) + batt_mv * BATTERY_FILTER_ALPHA;
     }
@@ -118,33 +129,31 @@ static float battery_filter_apply(float batt_mv)
     return battery_filtered_mv;
 }
 
-static void battery_update_charging_state(float delta_mv, int batt_mv)
+static void battery_update_charging_state(int batt_mv)
 {
-    if (delta_mv >= BATTERY_CHARGE_DELTA_MV) {
-        if (battery_charge_trend_count < 255U) {
-            battery_charge_trend_count++;
-        }
-        battery_discharge_trend_count = 0;
-    } else if (delta_mv <= BATTERY_DISCHARGE_DELTA_MV) {
-        if (battery_discharge_trend_count < 255U) {
-            battery_discharge_trend_count++;
-        }
-        battery_charge_trend_count = 0;
-    } else {
-        battery_reset_trend_counters();
+    bool was_charging = s_charge.charging;
+    float slope = 0.0f;
+    bool charging = pm_charge_update(&s_charge, batt_mv, &slope);
+
+    if (charging != was_charging && battery_step_us != 0) {
+        ESP_LOGI(TAG,
+            "Charger %s detected %lld ms after the voltage step (slope %.1f mV/s)",
+            charging ? "plug" : "unplug",
+            (long long)((esp_timer_get_time() - battery_step_us) / 1000),
+            (double)slope);
     }
+    /* A step that did not flip the state by now was a load transient. */
+    battery_step_us = 0;
+}
 
-    if (battery_charge_trend_count >= BATTERY_TREND_CONFIRM_SAMPLES) {
-        battery_charging = true;
-    } else if (battery_discharge_trend_count >= BATTERY_TREND_CONFIRM_SAMPLES) {
-        battery_charging = false;
-    } else {
-        if (batt_mv >= BATTERY_CHARGING_ABS_ON_MV) {
-            battery_charging = true;
-        } else if (batt_mv <= BATTERY_CHARGING_ABS_OFF_MV) {
-            battery_charging = false;
-        }
+static esp_err_t battery_raw_to_pin_mv(int raw, int* out_pin_mv)
+{
+    if (battery_cali_enabled) {
+        return adc_cali_raw_to_voltage(battery_cali_handle, raw, out_pin_mv);
     }
+
+    *out_pin_mv = (raw * 3300) / 4095;
+    return ESP_OK;
 }
 
 static esp_err_t battery_read_pin_mv(int* out_pin_mv)
@@ -159,16 +168,267 @@ static esp_err_t battery_read_pin_mv(int* out_pin_mv)
         return ret;
     }
 
-    if (battery_cali_enabled) {
-        return adc_cali_raw_to_voltage(battery_cali_handle, raw, out_pin_mv);
+    return battery_raw_to_pin_mv(raw, out_pin_mv);
+}
+
+static void battery_sort(int* values, uint32_t count)
+{
+    for (uint32_t i = 1; i < count; i++) {
+        int v = values[i];
+        uint32_t j = i;
+        while (j > 0 && values[j - 1] > v) {
+            values[j] = values[j - 1];
+            j--;
+        }
+        values[j] = v;
     }
+}
 
-    *out_pin_mv = (raw * 3300) / 4095;
-    return ESP_OK;
+/* Mean of the samples within BATTERY_OUTLIER_MAD_K median absolute deviations of the median. */
+static int battery_robust_mean(int* raw, uint32_t count, uint32_t* out_used)
+{
+    int dev[BATTERY_BURST_SAMPLES];
+
+    battery_sort(raw, count);
+    int median = raw[count / 2];
+
+    for (uint32_t i = 0; i < count; i++) {
+        dev[i] = (raw[i] > median) ? (raw[i] - median) : (median - raw[i]);
+    }
+    battery_sort(dev, count);
+    int limit = dev[count / 2] * BATTERY_OUTLIER_MAD_K;
+    if (limit < BATTERY_OUTLIER_MIN_RAW) {
+        limit = BATTERY_OUTLIER_MIN_RAW;
+    }
+
+    int32_t sum = 0;
+    uint32_t used = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        int d = (raw[i] > median) ? (raw[i] - median) : (median - raw[i]);
+        if (d <= limit) {
+            sum += raw[i];
+            used++;
+        }
+    }
+
+    *out_used = used;
+    return (int)((sum + (int32_t)(used / 2U)) / (int32_t)used);
+}
+
+static void battery_burst_finish(esp_err_t result)
+{
+    esp_timer_stop(s_burst.timer);
+    (void)battery_set_adc_enabled(false);
+
+    uint32_t used = 0;
+    int raw = 0;
+    if (result == ESP_OK) {
+        raw = battery_robust_mean(s_burst.raw, s_burst.count, &used);
+    }
+    int64_t now_us = esp_timer_get_time();
+
+    bool next = false;
+    portENTER_CRITICAL(&s_burst_lock);
+    if (result == ESP_OK && s_burst.fast_remaining > 0 && s_burst.fast_count < BATTERY_FAST_BURSTS) {
+        s_burst.fast_raw[s_burst.fast_count] = raw;
+        s_burst.fast_us[s_burst.fast_count] = now_us;
+        s_burst.fast_count++;
+        s_burst.fast_remaining--;
+        next = (s_burst.fast_remaining > 0);
+    } else {
+        s_burst.fast_remaining = 0;
+    }
+    if (!next) {
+        s_burst.result = result;
+        s_burst.result_raw = raw;
+        s_burst.result_us = now_us;
+        s_burst.used = used;
+        s_burst.state = BATTERY_BURST_DONE;
+    }
+    portEXIT_CRITICAL(&s_burst_lock);
+
+    if (next) {
+        /* Fast series: the next burst starts after a short gap, still from the timer. */
+        s_burst.gap = true;
+        if (esp_timer_start_once(s_burst.timer, BATTERY_FAST_GAP_US) != ESP_OK) {
+            s_burst.gap = false;
+            portENTER_CRITICAL(&s_burst_lock);
+            s_burst.fast_remaining = 0;
+            s_burst.result = ESP_OK;
+            s_burst.result_raw = raw;
+            s_burst.result_us = now_us;
+            s_burst.used = used;
+            s_burst.state = BATTERY_BURST_DONE;
+            portEXIT_CRITICAL(&s_burst_lock);
+        }
+    }
+}
+
+/* Powers the divider and arms the settle delay; sampling continues in the timer callback. */
+static esp_err_t battery_burst_begin(void)
+{
+    esp_err_t ret = battery_set_adc_enabled(true);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    s_burst.settling = true;
+    s_burst.count = 0;
+    ret = esp_timer_start_once(s_burst.timer, battery_settle_us);
+    if (ret != ESP_OK) {
+        (void)battery_set_adc_enabled(false);
+    }
+    return ret;
+}
+
+static void battery_burst_timer_cb(void* arg)
+{
+    (void)arg;
+
+    if (s_burst.gap) {
+        s_burst.gap = false;
+        esp_err_t ret = battery_burst_begin();
+        if (ret != ESP_OK) {
+            battery_burst_finish(ret);
+        }
+        return;
+    }
+
+    if (s_burst.settling) {
+        /* The one-shot settle delay ran out; sample from here on. */
+        s_burst.settling = false;
+        esp_err_t ret = esp_timer_start_periodic(s_burst.timer, BATTERY_BURST_PERIOD_US);
+        if (ret != ESP_OK) {
+            battery_burst_finish(ret);
+            return;
+        }
+    }
+
+    int raw = 0;
+    esp_err_t ret = adc_oneshot_read(battery_adc_handle, BATTERY_ADC_CHANNEL, &raw);
+    if (ret != ESP_OK) {
+        battery_burst_finish(ret);
+        return;
+    }
+
+    s_burst.raw[s_burst.count++] = raw;
+    if (s_burst.count == BATTERY_BURST_SAMPLES) {
+        battery_burst_finish(ESP_OK);
+    }
+}
+
+static esp_err_t battery_burst_start(uint32_t bursts)
+{
+    portENTER_CRITICAL(&s_burst_lock);
+    s_burst.state = BATTERY_BURST_RUNNING;
+    s_burst.fast_remaining = (bursts > 1U) ? bursts : 0U;
+    s_burst.fast_count = 0;
+    portEXIT_CRITICAL(&s_burst_lock);
+
+    esp_err_t ret = battery_burst_begin();
+    if (ret != ESP_OK) {
+        portENTER_CRITICAL(&s_burst_lock);
+        s_burst.state = BATTERY_BURST_IDLE;
+        s_burst.fast_remaining = 0;
+        portEXIT_CRITICAL(&s_burst_lock);
+    }
+    return ret;
+}
+
+static esp_err_t battery_raw_to_batt_mv(int raw, float* out_batt_mv)
+{
+    int pin_mv = 0;
+    esp_err_t ret = battery_raw_to_pin_mv(raw, &pin_mv);
+    if (ret == ESP_OK) {
+        *out_batt_mv = ((float)pin_mv) * BATTERY_DIVIDER_RATIO;
+    }
+    return ret;
+}
+
+/*
+ * Init only: switch the divider on and probe every 100 us until the reading
+ * stays within tolerance of its final value. The last samples double as the
+ * always-on reference for battery_check_gated_reading().
+ */
+static void battery_calibrate_settle(void)
+{
+    int trace[BATTERY_SETTLE_PROBE_SAMPLES];
+
+    (void)battery_set_adc_enabled(false);
+    esp_rom_delay_us(BATTERY_SETTLE_MAX_US);
+    (void)battery_set_adc_enabled(true);
+
+    for (uint32_t i = 0; i < BATTERY_SETTLE_PROBE_SAMPLES; i++) {
+        if (adc_oneshot_read(battery_adc_handle, BATTERY_ADC_CHANNEL, &trace[i]) != ESP_OK) {
+            ESP_LOGW(TAG, "Battery settle calibration failed, using %lu us", (unsigned long)battery_settle_us);
+            return;
+        }
+        esp_rom_delay_us(BATTERY_SETTLE_PROBE_US);
+    }
+
+    int32_t final_sum = 0;
+    for (uint32_t i = BATTERY_SETTLE_PROBE_SAMPLES - BATTERY_SETTLE_FINAL_SAMPLES; i < BATTERY_SETTLE_PROBE_SAMPLES; i++) {
+        final_sum += trace[i];
+    }
+    int final_raw = (int)(final_sum / (int32_t)BATTERY_SETTLE_FINAL_SAMPLES);
+
+    uint32_t settled = BATTERY_SETTLE_PROBE_SAMPLES;
+    while (settled > 0) {
+        int d = trace[settled - 1] - final_raw;
+        if (d > BATTERY_SETTLE_TOLERANCE_RAW || d < -BATTERY_SETTLE_TOLERANCE_RAW) {
+            break;
+        }
+        settled--;
+    }
+
+    uint32_t observed_us = (settled + 1U) * BATTERY_SETTLE_PROBE_US;
+    if (settled >= BATTERY_SETTLE_PROBE_SAMPLES - BATTERY_SETTLE_FINAL_SAMPLES) {
+        battery_settle_us = BATTERY_SETTLE_MAX_US;
+    } else {
+        battery_settle_us = observed_us * 2U;
+        if (battery_settle_us < BATTERY_SETTLE_MIN_US) {
+            battery_settle_us = BATTERY_SETTLE_MIN_US;
+        } else if (battery_settle_us > BATTERY_SETTLE_MAX_US) {
+            battery_settle_us = BATTERY_SETTLE_MAX_US;
+        }
+    }
+    battery_reference_raw = final_raw;
+
+    ESP_LOGI(TAG,
+        "Battery divider settles in ~%lu us, gating with %lu us",
+        (unsigned long)observed_us,
+        (unsigned long)battery_settle_us);
+}
+
+/* First gated reading: compare with the always-on reference and report the expected saving. */
+static void battery_check_gated_reading(int raw, int batt_mv)
+{
+    if (battery_reference_raw < 0) {
+        return;
+    }
+
+    int ref_pin_mv = 0;
+    if (battery_raw_to_pin_mv(battery_reference_raw, &ref_pin_mv) == ESP_OK) {
+        int ref_mv = (int)((float)ref_pin_mv * BATTERY_DIVIDER_RATIO + 0.5f);
+        uint32_t on_us = battery_settle_us + BATTERY_BURST_SAMPLES * BATTERY_BURST_PERIOD_US;
+        uint32_t always_on_ua = (uint32_t)batt_mv * 1000U / BATTERY_DIVIDER_TOTAL_OHMS;
+        ESP_LOGI(TAG,
+            "Battery gated read %d mV vs always-on %d mV (raw %d vs %d); divider on %lu us per read, "
+            "~%lu uA saved",
+            batt_mv,
+            ref_mv,
+            raw,
+            battery_reference_raw,
+            (unsigned long)on_us,
+            (unsigned long)always_on_ua);
+    }
+    battery_reference_raw = -1;
 }
 
 static void battery_monitor_init(void)
 {
+    pm_charge_init(&s_charge);
+
     gpio_config_t adc_en_cfg = {
         .pin_bit_mask = (1ULL << BATTERY_ADC_EN_GPIO),
         .mode = GPIO_MODE_OUTPUT,
@@ -241,7 +501,23 @@ static void battery_monitor_init(void)
         ESP_LOGW(TAG, "Battery ADC_EN autodetect skipped (high_ok=%d, low_ok=%d)", high_ok, low_ok);
     }
 
-    (void)battery_set_adc_enabled(true);
+    battery_calibrate_settle();
+    (void)battery_set_adc_enabled(false);
+
+    const esp_timer_create_args_t burst_timer_args = {
+        .callback = battery_burst_timer_cb,
+        .name = "batt_adc",
+    };
+    ret = esp_timer_create(&burst_timer_args, &s_burst.timer);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Battery burst timer create failed: %s", esp_err_to_name(ret));
+        s_burst.timer = NULL;
+        return;
+    }
+
+    /* The first reading is ready by the time the sensor task asks for it. */
+    (void)battery_burst_start(1);
+
     ESP_LOGI(TAG,
         "Battery monitor initialized (cali=%s, adc_en=active_%s)",
         battery_cali_enabled ? "on" : "off",
@@ -253,6 +529,11 @@ void pm_battery_init(void)
     battery_monitor_init();
 }
 
+bool pm_battery_is_charging(void)
+{
+    return s_charge.charging;
+}
+
 esp_err_t power_manager_read_battery(power_battery_info_t* out_info)
 {
     if (!out_info) {
@@ -260,42 +541,93 @@ esp_err_t power_manager_read_battery(power_battery_info_t* out_info)
     }
 
     memset(out_info, 0, sizeof(*out_info));
-    if (!battery_adc_handle) {
+    if (!battery_adc_handle || !s_burst.timer) {
         return ESP_ERR_INVALID_STATE;
     }
 
-    esp_err_t ret = battery_set_adc_enabled(true);
+    int fast_raw[BATTERY_FAST_BURSTS];
+    int64_t fast_us[BATTERY_FAST_BURSTS];
+    uint32_t fast_count = 0;
+
+    portENTER_CRITICAL(&s_burst_lock);
+    battery_burst_state_t state = s_burst.state;
+    esp_err_t ret = s_burst.result;
+    int raw = s_burst.result_raw;
+    int64_t result_us = s_burst.result_us;
+    if (state == BATTERY_BURST_DONE) {
+        s_burst.state = BATTERY_BURST_IDLE;
+        fast_count = s_burst.fast_count;
+        memcpy(fast_raw, s_burst.fast_raw, fast_count * sizeof(fast_raw[0]));
+        memcpy(fast_us, s_burst.fast_us, fast_count * sizeof(fast_us[0]));
+        s_burst.fast_count = 0;
+    }
+    portEXIT_CRITICAL(&s_burst_lock);
+
+    if (state == BATTERY_BURST_IDLE) {
+        ret = battery_burst_start(1);
+        return (ret == ESP_OK) ? ESP_ERR_NOT_FINISHED : ret;
+    }
+    if (state == BATTERY_BURST_RUNNING) {
+        return ESP_ERR_NOT_FINISHED;
+    }
     if (ret != ESP_OK) {
         return ret;
     }
-    esp_rom_delay_us(2000);
 
-    int pin_mv = 0;
-    ret = battery_read_pin_mv(&pin_mv);
+    /* Detection runs on the load-compensated voltage, so backlight or CPU steps do not look like a plug. */
+    float batt_mv = 0.0f;
+    if (fast_count > 0) {
+        for (uint32_t i = 0; i < fast_count; i++) {
+            if (battery_raw_to_batt_mv(fast_raw[i], &batt_mv) == ESP_OK) {
+                (void)pm_charge_push(&s_charge, fast_us[i], pm_soc_compensate_mv(batt_mv));
+            }
+        }
+    }
+
+    ret = battery_raw_to_batt_mv(raw, &batt_mv);
     if (ret != ESP_OK) {
         return ret;
     }
 
-    float batt_mv = ((float)pin_mv) * BATTERY_DIVIDER_RATIO;
+    if (fast_count == 0 && pm_charge_push(&s_charge, result_us, pm_soc_compensate_mv(batt_mv))) {
+        /* Plug or unplug suspected: follow up with a fast series and decide on its slope. */
+        battery_step_us = result_us;
+        if (battery_burst_start(BATTERY_FAST_BURSTS) == ESP_OK) {
+            return ESP_ERR_NOT_FINISHED;
+        }
+    }
+
+    battery_check_gated_reading(raw, (int)(batt_mv + 0.5f));
     battery_filter_apply(batt_mv);
-    float delta_mv = battery_filtered_mv - battery_prev_mv;
-    battery_prev_mv = battery_filtered_mv;
 
     int mv_rounded = (int)(battery_filtered_mv + 0.5f);
     out_info->voltage_mv = (mv_rounded > 0) ? (uint16_t)mv_rounded : 0U;
 
     if (mv_rounded < BATTERY_VALID_MIN_MV || mv_rounded > BATTERY_VALID_MAX_MV) {
-        battery_reset_trend_counters();
+        pm_charge_reset(&s_charge);
+        battery_reported_pct = -1;
+        pm_soc_reset_filter();
         out_info->percent = -1;
         out_info->charging = false;
         out_info->valid = false;
         return ESP_OK;
     }
 
-    battery_update_charging_state(delta_mv, mv_rounded);
+    bool was_charging = s_charge.charging;
+    battery_update_charging_state(mv_rounded);
+    if (s_charge.charging != was_charging) {
+        pm_cpu_profile_update();
+    }
+
+    /* Hold the shown percent until it moves by a full hysteresis step, so it never flickers. */
+    int pct = pm_soc_update((int)(batt_mv + 0.5f), s_charge.charging, esp_timer_get_time());
+    if (battery_reported_pct < 0 || pct >= battery_reported_pct + BATTERY_PERCENT_HYSTERESIS ||
+        pct <= battery_reported_pct - BATTERY_PERCENT_HYSTERESIS || pct == 0 || pct == 100) {
+        battery_reported_pct = pct;
+    }
 
-    out_info->percent = battery_percent_from_mv(mv_rounded);
-    out_info->charging = battery_charging;
+    out_info->percent = battery_reported_pct;
+    out_info->charging = s_charge.charging;
     out_info->valid = true;
 
     return ESP_OK;
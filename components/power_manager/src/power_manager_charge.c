@@ -0,0 +1,156 @@
+#include "power_manager_charge.h"
+
+#include <string.h>
+
+void pm_charge_init(pm_charge_detect_t* det)
+{
+    memset(det, 0, sizeof(*det));
+}
+
+void pm_charge_reset(pm_charge_detect_t* det)
+{
+    det->head = 0;
+    det->count = 0;
+    det->step_points = 0;
+}
+
+/* Index of the reading @p age pushes back; 0 is the newest. */
+static uint32_t charge_index(const pm_charge_detect_t* det, uint32_t age)
+{
+    return (det->head + BATTERY_CHARGE_HISTORY - 1U - age) % BATTERY_CHARGE_HISTORY;
+}
+
+/* Median of the newest @p n readings, n <= BATTERY_STEP_REF_POINTS (fewer if there are not as many). */
+static float charge_recent_median(const pm_charge_detect_t* det, uint32_t n)
+{
+    float v[BATTERY_STEP_REF_POINTS];
+    if (n > det->count) {
+        n = det->count;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        float x = det->mv[charge_index(det, i)];
+        uint32_t j = i;
+        while (j > 0 && v[j - 1U] > x) {
+            v[j] = v[j - 1U];
+            j--;
+        }
+        v[j] = x;
+    }
+    return v[n / 2U];
+}
+
+bool pm_charge_push(pm_charge_detect_t* det, int64_t t_us, float mv)
+{
+    bool step = false;
+    if (det->count > 0) {
+        uint32_t last = charge_index(det, 0);
+        if ((t_us - det->t_us[last]) > BATTERY_SLOPE_MAX_GAP_US) {
+            /* Not read for a while (monitoring); the old points say nothing about now. */
+            pm_charge_reset(det);
+        } else {
+            float d = mv - det->mv[last];
+            step = (d >= BATTERY_STEP_SUSPECT_MV) || (d <= -BATTERY_STEP_SUSPECT_MV);
+            if (det->step_points > 0) {
+                if (det->step_points < BATTERY_CHARGE_HISTORY) {
+                    det->step_points++;
+                }
+            } else if (step) {
+                det->step_points = 1;
+                det->step_ref_mv = charge_recent_median(det, BATTERY_STEP_REF_POINTS);
+            }
+        }
+    }
+
+    det->t_us[det->head] = t_us;
+    det->mv[det->head] = mv;
+    det->head = (det->head + 1U) % BATTERY_CHARGE_HISTORY;
+    if (det->count < BATTERY_CHARGE_HISTORY) {
+        det->count++;
+    }
+    return step;
+}
+
+bool pm_charge_slope(const pm_charge_detect_t* det, float* out_mv_per_s)
+{
+    uint32_t n = (det->count < BATTERY_SLOPE_WINDOW) ? det->count : BATTERY_SLOPE_WINDOW;
+    if (n < BATTERY_SLOPE_MIN_POINTS) {
+        return false;
+    }
+
+    int64_t t0 = det->t_us[charge_index(det, n - 1U)];
+    float t[BATTERY_SLOPE_WINDOW];
+    float v[BATTERY_SLOPE_WINDOW];
+    float sum_t = 0.0f;
+    float sum_v = 0.0f;
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t k = charge_index(det, i);
+        t[i] = (float)(det->t_us[k] - t0) / 1000000.0f;
+        v[i] = det->mv[k];
+        sum_t += t[i];
+        sum_v += v[i];
+    }
+    float mean_t = sum_t / (float)n;
+    float mean_v = sum_v / (float)n;
+
+    float sxx = 0.0f;
+    float sxy = 0.0f;
+    for (uint32_t i = 0; i < n; i++) {
+        float dt = t[i] - mean_t;
+        sxx += dt * dt;
+        sxy += dt * (v[i] - mean_v);
+    }
+    if (sxx <= 0.0f) {
+        return false;
+    }
+
+    *out_mv_per_s = sxy / sxx;
+    return true;
+}
+
+/* Drops the readings since a step that did not hold, keeping the newest one. */
+static void charge_drop_transient(pm_charge_detect_t* det)
+{
+    uint32_t newest = charge_index(det, 0);
+    int64_t t_us = det->t_us[newest];
+    float mv = det->mv[newest];
+
+    det->head = (det->head + BATTERY_CHARGE_HISTORY - det->step_points) % BATTERY_CHARGE_HISTORY;
+    det->count -= det->step_points;
+    det->t_us[det->head] = t_us;
+    det->mv[det->head] = mv;
+    det->head = (det->head + 1U) % BATTERY_CHARGE_HISTORY;
+    det->count++;
+}
+
+bool pm_charge_update(pm_charge_detect_t* det, int batt_mv, float* out_slope)
+{
+    float slope = 0.0f;
+
+    if (det->step_points > 0) {
+        uint32_t n = (det->step_points < BATTERY_STEP_REF_POINTS) ? det->step_points : BATTERY_STEP_REF_POINTS;
+        float held = charge_recent_median(det, n) - det->step_ref_mv;
+        if (held < BATTERY_STEP_SUSPECT_MV && held > -BATTERY_STEP_SUSPECT_MV) {
+            charge_drop_transient(det);
+        }
+        det->step_points = 0;
+    }
+
+    if (batt_mv >= BATTERY_CHARGING_ABS_ON_MV) {
+        det->charging = true;
+    } else if (pm_charge_slope(det, &slope)) {
+        /* Hysteresis: between the two thresholds the state holds. */
+        if (slope >= BATTERY_SLOPE_ON_MV_S) {
+            det->charging = true;
+        } else if (slope <= BATTERY_SLOPE_OFF_MV_S) {
+            det->charging = false;
+        }
+    } else if (det->count <= 1U && batt_mv <= BATTERY_CHARGING_ABS_OFF_MV) {
+        /* First reading (boot or after a gap), only the absolute level to go on. */
+        det->charging = false;
+    }
+
+    if (out_slope) {
+        *out_slope = slope;
+    }
+    return det->charging;
+}
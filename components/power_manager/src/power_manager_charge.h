@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Charger detection from battery readings. Plain C with no ESP-IDF
+ * dependencies, so test/host can replay voltage traces through it.
+ */
+
+/* Least-squares slope of the load-compensated voltage over the last readings. */
+#define BATTERY_SLOPE_WINDOW 8U
+#define BATTERY_SLOPE_MIN_POINTS 3U
+#define BATTERY_SLOPE_MAX_GAP_US (10LL * 1000000LL)
+#define BATTERY_SLOPE_ON_MV_S 4.0f
+#define BATTERY_SLOPE_OFF_MV_S -4.0f
+/* A step this large between readings (plug or unplug) triggers a fast series of bursts. */
+#define BATTERY_STEP_SUSPECT_MV 20.0f
+/*
+ * The step is a plug or unplug only if the level after it is still a full
+ * step away from the level before it, each the median of the last readings on
+ * that side. Otherwise it was a load transient and is dropped.
+ */
+#define BATTERY_STEP_REF_POINTS 3U
+#define BATTERY_FAST_BURSTS 6U
+#define BATTERY_FAST_GAP_US 50000U
+#define BATTERY_CHARGING_ABS_ON_MV 4400
+#define BATTERY_CHARGING_ABS_OFF_MV 4250
+/* Readings kept: a window plus a step and its fast series, so dropping a transient restores the window. */
+#define BATTERY_CHARGE_HISTORY (BATTERY_SLOPE_WINDOW + 1U + BATTERY_FAST_BURSTS)
+
+typedef struct {
+    int64_t t_us[BATTERY_CHARGE_HISTORY];
+    float mv[BATTERY_CHARGE_HISTORY];
+    uint32_t head;
+    uint32_t count;
+    bool charging;
+    /* Suspected step: readings pushed since it (itself included) and the level before it. */
+    uint32_t step_points;
+    float step_ref_mv;
+} pm_charge_detect_t;
+
+/* Starts with an empty window and charging off. */
+void pm_charge_init(pm_charge_detect_t* det);
+/* Drops the readings; the charging state holds. */
+void pm_charge_reset(pm_charge_detect_t* det);
+/* Adds a reading; returns true when it jumped away from the previous one by a plug-sized step. */
+bool pm_charge_push(pm_charge_detect_t* det, int64_t t_us, float mv);
+/* Least-squares slope over the newest BATTERY_SLOPE_WINDOW readings, in mV/s; false with too few. */
+bool pm_charge_slope(const pm_charge_detect_t* det, float* out_mv_per_s);
+/*
+ * Re-evaluates the charging state from the window and @p batt_mv, the filtered
+ * voltage. A suspected step that did not hold is dropped from the window
+ * first, so a load transient neither flips the state nor skews later fits.
+ * Returns the new state; @p out_slope (optional) gets the fitted
+ * slope, or 0 when there was none.
+ */
+bool pm_charge_update(pm_charge_detect_t* det, int batt_mv, float* out_slope);
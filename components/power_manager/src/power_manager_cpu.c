@@ -0,0 +1,188 @@
+#include "power_manager_internal.h"
+
+#include "bme680_sensor.h"
+#include "display_lvgl.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_pm.h"
+#include "esp_timer.h"
+
+#if CONFIG_PM_ENABLE
+static const char* TAG = "power_mgr";
+
+/*
+ * CPU frequency ceiling per device mode. The render burst and bsec_do_steps
+ * hold ESP_PM_CPU_FREQ_MAX locks, which run at the ceiling of the current
+ * profile, and DFS drops to the minimum in between. On every profile change
+ * the time spent per frame and per BSEC step under the profile being left is
+ * logged with an energy estimate from the CPU current model, and, with
+ * CONFIG_PM_LIGHT_SLEEP_CALLBACKS, the light sleep wakeups per second.
+ */
+
+/* Cell voltage used for the energy estimates. */
+#define CPU_ENERGY_SUPPLY_MV 3700.0f
+
+typedef enum {
+    CPU_PROFILE_ACTIVE = 0,
+    CPU_PROFILE_MONITORING,
+    CPU_PROFILE_CHARGING,
+    CPU_PROFILE_COUNT,
+} cpu_profile_t;
+
+static const char* const cpu_profile_names[CPU_PROFILE_COUNT] = {"active", "monitoring", "charging"};
+static const int cpu_profile_max_mhz[CPU_PROFILE_COUNT] = {
+    CONFIG_PM_CPU_MAX_MHZ_ACTIVE,
+    CONFIG_PM_CPU_MAX_MHZ_MONITORING,
+    CONFIG_PM_CPU_MAX_MHZ_CHARGING,
+};
+
+static int s_cpu_profile = -1;
+static int64_t s_profile_start_us;
+static display_lvgl_stats_t s_disp_base;
+static uint32_t s_bsec_steps_base;
+static uint64_t s_bsec_us_base;
+
+#if CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+/* Light sleep exits and time asleep, counted from the sleep exit callback; the idle wakeup rate per profile. */
+static volatile uint32_t s_sleep_wakeups;
+static volatile uint64_t s_sleep_us;
+static uint32_t s_sleep_wakeups_base;
+static uint64_t s_sleep_us_base;
+
+static IRAM_ATTR int cpu_light_sleep_exit_cb(int64_t sleep_time_us, void* arg)
+{
+    (void)arg;
+    s_sleep_wakeups++;
+    s_sleep_us += (uint64_t)sleep_time_us;
+    return ESP_OK;
+}
+
+static void cpu_sleep_stats_init(void)
+{
+    esp_pm_sleep_cbs_register_config_t cbs = {
+        .exit_cb = cpu_light_sleep_exit_cb,
+    };
+    esp_err_t ret = esp_pm_light_sleep_register_cbs(&cbs);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Light sleep wakeup counter unavailable: %s", esp_err_to_name(ret));
+    }
+}
+
+static void cpu_sleep_stats_report(int64_t elapsed_us)
+{
+    uint32_t wakeups = s_sleep_wakeups - s_sleep_wakeups_base;
+    uint64_t sleep_us = s_sleep_us - s_sleep_us_base;
+    s_sleep_wakeups_base += wakeups;
+    s_sleep_us_base += sleep_us;
+    if (elapsed_us <= 0) {
+        return;
+    }
+
+    ESP_LOGI(TAG,
+        "Light sleep: %lu wakeups, %.2f/s, %.1f%% of the time asleep",
+        (unsigned long)wakeups,
+        (double)((float)wakeups * 1000000.0f / (float)elapsed_us),
+        (double)((float)sleep_us * 100.0f / (float)elapsed_us));
+}
+#endif
+
+/* Counters may have been reset elsewhere (render stats log, sensor re-init); then count from zero. */
+static uint64_t cpu_counter_delta(uint64_t now, uint64_t base)
+{
+    return (now >= base) ? (now - base) : now;
+}
+
+static void cpu_profile_report(int profile)
+{
+    display_lvgl_stats_t disp = {0};
+    display_lvgl_get_stats(&disp, false);
+    uint32_t bsec_steps = 0;
+    uint64_t bsec_us = 0;
+    bme680_sensor_get_bsec_stats(&bsec_steps, &bsec_us);
+
+    if (profile >= 0) {
+        uint32_t frames = (uint32_t)cpu_counter_delta(disp.frames, s_disp_base.frames);
+        uint64_t refresh_us = cpu_counter_delta(disp.refresh_us, s_disp_base.refresh_us);
+        uint32_t steps = (uint32_t)cpu_counter_delta(bsec_steps, s_bsec_steps_base);
+        uint64_t step_us = cpu_counter_delta(bsec_us, s_bsec_us_base);
+
+        /* mW at the ceiling; mW * us = nJ. */
+        float mw = CPU_ENERGY_SUPPLY_MV * pm_soc_cpu_current_ma((uint32_t)cpu_profile_max_mhz[profile]) / 1000.0f;
+        float frame_us = frames ? (float)refresh_us / (float)frames : 0.0f;
+        float bsec_step_us = steps ? (float)step_us / (float)steps : 0.0f;
+
+        ESP_LOGI(TAG,
+            "CPU profile %s (%d MHz, %lld s): %lu frames, %.2f ms ~%.0f uJ each; %lu BSEC steps, %.2f ms ~%.0f uJ each",
+            cpu_profile_names[profile],
+            cpu_profile_max_mhz[profile],
+            (long long)((esp_timer_get_time() - s_profile_start_us) / 1000000LL),
+            (unsigned long)frames,
+            (double)(frame_us / 1000.0f),
+            (double)(mw * frame_us / 1000.0f),
+            (unsigned long)steps,
+            (double)(bsec_step_us / 1000.0f),
+            (double)(mw * bsec_step_us / 1000.0f));
+#if CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+        cpu_sleep_stats_report(esp_timer_get_time() - s_profile_start_us);
+#endif
+    }
+
+    s_disp_base = disp;
+    s_bsec_steps_base = bsec_steps;
+    s_bsec_us_base = bsec_us;
+    s_profile_start_us = esp_timer_get_time();
+}
+
+void pm_cpu_profile_update(void)
+{
+    /*
+     * The charger warms the board, so charging may only lower the ceiling of
+     * the display state, never raise it (monitoring stays at its own).
+     */
+    cpu_profile_t next = s_is_monitoring ? CPU_PROFILE_MONITORING : CPU_PROFILE_ACTIVE;
+    if (pm_battery_is_charging() && cpu_profile_max_mhz[CPU_PROFILE_CHARGING] < cpu_profile_max_mhz[next]) {
+        next = CPU_PROFILE_CHARGING;
+    }
+    if ((int)next == s_cpu_profile) {
+        return;
+    }
+
+    esp_pm_config_t pm_config;
+    esp_err_t ret = esp_pm_get_configuration(&pm_config);
+    if (ret != ESP_OK) {
+        return;
+    }
+    pm_config.max_freq_mhz = cpu_profile_max_mhz[next];
+    if (pm_config.min_freq_mhz > pm_config.max_freq_mhz) {
+        pm_config.min_freq_mhz = pm_config.max_freq_mhz;
+    }
+
+    ret = esp_pm_configure(&pm_config);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG,
+            "CPU profile %s (%d MHz) rejected: %s",
+            cpu_profile_names[next],
+            cpu_profile_max_mhz[next],
+            esp_err_to_name(ret));
+        return;
+    }
+
+#if CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+    if (s_cpu_profile < 0) {
+        cpu_sleep_stats_init();
+    }
+#endif
+    cpu_profile_report(s_cpu_profile);
+    s_cpu_profile = (int)next;
+    ESP_LOGI(TAG,
+        "CPU profile %s: %d..%d MHz",
+        cpu_profile_names[next],
+        pm_config.min_freq_mhz,
+        pm_config.max_freq_mhz);
+}
+#else
+void pm_cpu_profile_update(void)
+{
+    /* Without DFS the CPU runs at one fixed frequency; there is nothing to cap. */
+}
+#endif
@@ -0,0 +1,318 @@
+#include "power_manager_internal.h"
+
+#include <string.h>
+#include <sys/time.h>
+
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+#include "settings.h"
+
+static const char* TAG = "power_mgr";
+
+#define IDLE_NVS_NAMESPACE "app_settings"
+#define IDLE_NVS_KEY_LADDER "idle_ladder"
+#define IDLE_NVS_KEY_STATS "idle_stats"
+#define IDLE_RECORD_VERSION 1U
+#define IDLE_DIM_FADE_MS 400
+
+typedef struct {
+    uint16_t version;
+    power_idle_thresholds_t battery;
+    power_idle_thresholds_t charging;
+} idle_ladder_record_t;
+
+typedef struct {
+    uint16_t version;
+    uint64_t stage_s[POWER_IDLE_STAGE_COUNT];
+} idle_stats_record_t;
+
+static const char* const idle_stage_names[POWER_IDLE_STAGE_COUNT] = {"active", "dim", "display off", "deep sleep"};
+
+static idle_ladder_record_t s_ladder = {
+    .version = IDLE_RECORD_VERSION,
+    .battery =
+        {
+            .dim_s = CONFIG_PM_IDLE_DIM_S,
+            .display_off_s = CONFIG_PM_IDLE_DISPLAY_OFF_S,
+            .deep_sleep_s = CONFIG_PM_IDLE_DEEP_SLEEP_H * 3600U,
+        },
+    .charging =
+        {
+            .dim_s = CONFIG_PM_IDLE_CHARGING_DIM_S,
+            .display_off_s = CONFIG_PM_IDLE_CHARGING_DISPLAY_OFF_S,
+            .deep_sleep_s = 0,
+        },
+};
+static idle_stats_record_t s_stats = {.version = IDLE_RECORD_VERSION};
+static power_idle_stage_t s_stage = POWER_IDLE_STAGE_ACTIVE;
+static int64_t s_stage_since_us;
+
+/*
+ * Idle bookkeeping across deep sleep. Slept time is credited on the next boot,
+ * into RTC memory on deep monitoring timer wakes (no NVS writes there) and
+ * into the NVS stats on the next full boot.
+ */
+typedef struct {
+    /**< Wall time the current deep sleep started, 0 when not sleeping. */
+    int64_t sleep_wall_us;
+    /**< Stage the current deep sleep counts towards. */
+    uint8_t sleep_stage;
+    /**< Seconds per stage not yet added to the NVS stats. */
+    uint32_t pending_s[POWER_IDLE_STAGE_COUNT];
+    /**< Wall time from which deep monitoring gives way to button-only deep sleep, 0 for never. */
+    int64_t deep_sleep_wall_us;
+} idle_rtc_state_t;
+
+static RTC_DATA_ATTR idle_rtc_state_t s_rtc_idle;
+
+static int64_t idle_wall_time_us(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+static bool idle_load_blob(const char* key, void* out, size_t size)
+{
+    return settings_get_blob(IDLE_NVS_NAMESPACE, key, out, size) == ESP_OK;
+}
+
+static void idle_save_blob(const char* key, const void* data, size_t size)
+{
+    esp_err_t ret = settings_set_blob(IDLE_NVS_NAMESPACE, key, data, size);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to persist %s: %s", key, esp_err_to_name(ret));
+    }
+}
+
+/* Stages must come in order; a zero threshold skips its stage. */
+static bool idle_thresholds_valid(const power_idle_thresholds_t* t)
+{
+    uint32_t last = 0;
+    const uint32_t steps[] = {t->dim_s, t->display_off_s, t->deep_sleep_s};
+    for (size_t i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+        if (steps[i] == 0U) {
+            continue;
+        }
+        if (steps[i] <= last) {
+            return false;
+        }
+        last = steps[i];
+    }
+    return true;
+}
+
+static const power_idle_thresholds_t* idle_current_thresholds(void)
+{
+    return pm_battery_is_charging() ? &s_ladder.charging : &s_ladder.battery;
+}
+
+static void idle_credit_rtc_sleep(void)
+{
+    if (s_rtc_idle.sleep_wall_us == 0) {
+        return;
+    }
+
+    int64_t slept_us = idle_wall_time_us() - s_rtc_idle.sleep_wall_us;
+    if (slept_us > 0 && s_rtc_idle.sleep_stage < POWER_IDLE_STAGE_COUNT) {
+        s_rtc_idle.pending_s[s_rtc_idle.sleep_stage] += (uint32_t)(slept_us / 1000000LL);
+    }
+    s_rtc_idle.sleep_wall_us = 0;
+}
+
+static void idle_account_stage(void)
+{
+    int64_t now = esp_timer_get_time();
+    s_stats.stage_s[s_stage] += (uint64_t)((now - s_stage_since_us) / 1000000LL);
+    /* Keep the sub-second remainder with the stage it belongs to. */
+    s_stage_since_us = now - ((now - s_stage_since_us) % 1000000LL);
+}
+
+static void idle_log_stats(void)
+{
+    ESP_LOGI(TAG,
+        "Idle stages so far: active %llu min, dim %llu min, display off %llu min, deep sleep %llu min",
+        (unsigned long long)(s_stats.stage_s[POWER_IDLE_STAGE_ACTIVE] / 60U),
+        (unsigned long long)(s_stats.stage_s[POWER_IDLE_STAGE_DIM] / 60U),
+        (unsigned long long)(s_stats.stage_s[POWER_IDLE_STAGE_DISPLAY_OFF] / 60U),
+        (unsigned long long)(s_stats.stage_s[POWER_IDLE_STAGE_DEEP_SLEEP] / 60U));
+}
+
+static void idle_set_stage(power_idle_stage_t stage)
+{
+    idle_account_stage();
+    ESP_LOGI(TAG, "Idle stage: %s -> %s", idle_stage_names[s_stage], idle_stage_names[stage]);
+    s_stage = stage;
+
+    /* Persisted on the way down only; the settings debounce folds the steps of one idle period together. */
+    if (stage == POWER_IDLE_STAGE_DISPLAY_OFF || stage == POWER_IDLE_STAGE_DEEP_SLEEP) {
+        idle_save_blob(IDLE_NVS_KEY_STATS, &s_stats, sizeof(s_stats));
+        idle_log_stats();
+    }
+}
+
+void pm_idle_init(void)
+{
+    idle_ladder_record_t ladder;
+    if (idle_load_blob(IDLE_NVS_KEY_LADDER, &ladder, sizeof(ladder)) && ladder.version == IDLE_RECORD_VERSION &&
+        idle_thresholds_valid(&ladder.battery) && idle_thresholds_valid(&ladder.charging)) {
+        s_ladder = ladder;
+    }
+
+    idle_stats_record_t stats;
+    if (idle_load_blob(IDLE_NVS_KEY_STATS, &stats, sizeof(stats)) && stats.version == IDLE_RECORD_VERSION) {
+        s_stats = stats;
+    }
+
+    /* RTC memory also survives a reset; only a deep sleep wake has anything to credit. */
+    if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_UNDEFINED) {
+        memset(&s_rtc_idle, 0, sizeof(s_rtc_idle));
+    }
+    idle_credit_rtc_sleep();
+    bool credited = false;
+    for (size_t i = 0; i < POWER_IDLE_STAGE_COUNT; i++) {
+        credited = credited || (s_rtc_idle.pending_s[i] != 0U);
+        s_stats.stage_s[i] += s_rtc_idle.pending_s[i];
+    }
+    memset(&s_rtc_idle, 0, sizeof(s_rtc_idle));
+    if (credited) {
+        idle_save_blob(IDLE_NVS_KEY_STATS, &s_stats, sizeof(s_stats));
+    }
+
+    s_stage = POWER_IDLE_STAGE_ACTIVE;
+    s_stage_since_us = esp_timer_get_time();
+    ESP_LOGI(TAG,
+        "Idle ladder (battery): dim %lu s, display off %lu s, deep sleep %lu s",
+        (unsigned long)s_ladder.battery.dim_s,
+        (unsigned long)s_ladder.battery.display_off_s,
+        (unsigned long)s_ladder.battery.deep_sleep_s);
+    idle_log_stats();
+}
+
+bool pm_idle_before_deep_sleep(bool monitoring)
+{
+    /* Zero on a deep monitoring timer wake, where pm_idle_init() has not run. */
+    bool full_boot = (s_stage_since_us != 0);
+    idle_credit_rtc_sleep();
+
+    bool deep = !monitoring ||
+                (s_rtc_idle.deep_sleep_wall_us != 0 && idle_wall_time_us() >= s_rtc_idle.deep_sleep_wall_us);
+    if (deep && monitoring) {
+        ESP_LOGI(TAG, "Idle deep sleep threshold reached during deep monitoring");
+    }
+
+    if (full_boot) {
+        if (deep && s_stage != POWER_IDLE_STAGE_DEEP_SLEEP) {
+            idle_set_stage(POWER_IDLE_STAGE_DEEP_SLEEP);
+        } else {
+            idle_account_stage();
+            idle_save_blob(IDLE_NVS_KEY_STATS, &s_stats, sizeof(s_stats));
+        }
+    }
+
+    s_rtc_idle.sleep_stage = deep ? POWER_IDLE_STAGE_DEEP_SLEEP : POWER_IDLE_STAGE_DISPLAY_OFF;
+    s_rtc_idle.sleep_wall_us = idle_wall_time_us();
+    return deep;
+}
+
+void power_manager_process_idle(int64_t idle_us)
+{
+    const power_idle_thresholds_t* t = idle_current_thresholds();
+    int64_t idle_s = idle_us / 1000000LL;
+
+    power_idle_stage_t target = POWER_IDLE_STAGE_ACTIVE;
+    if (t->dim_s != 0U && idle_s >= (int64_t)t->dim_s) {
+        target = POWER_IDLE_STAGE_DIM;
+    }
+    if (t->display_off_s != 0U && idle_s >= (int64_t)t->display_off_s) {
+        target = POWER_IDLE_STAGE_DISPLAY_OFF;
+    }
+    if (t->deep_sleep_s != 0U && idle_s >= (int64_t)t->deep_sleep_s) {
+        target = POWER_IDLE_STAGE_DEEP_SLEEP;
+    }
+
+    /* The ladder only goes down here; going back up is power_manager_wake_from_idle(). */
+    if (target <= s_stage) {
+        return;
+    }
+
+    if (target == POWER_IDLE_STAGE_DIM) {
+        idle_set_stage(POWER_IDLE_STAGE_DIM);
+        uint8_t active = power_manager_get_active_brightness();
+        uint8_t dim = (active < CONFIG_PM_IDLE_DIM_PCT) ? active : CONFIG_PM_IDLE_DIM_PCT;
+        if (s_pm_config.bl_handle) {
+            backlight_fade_to(s_pm_config.bl_handle, dim, IDLE_DIM_FADE_MS);
+        }
+        return;
+    }
+
+    if (s_stage < POWER_IDLE_STAGE_DISPLAY_OFF) {
+        idle_set_stage(POWER_IDLE_STAGE_DISPLAY_OFF);
+        /* Deep monitoring reboots on every sample, so the deadline has to live in RTC memory. */
+        s_rtc_idle.deep_sleep_wall_us =
+            (t->deep_sleep_s != 0U) ? idle_wall_time_us() + ((int64_t)t->deep_sleep_s - idle_s) * 1000000LL : 0;
+        power_manager_enter_monitoring();
+    }
+    if (target == POWER_IDLE_STAGE_DEEP_SLEEP) {
+        pm_idle_deep_sleep();
+    }
+}
+
+void power_manager_wake_from_idle(void)
+{
+    power_idle_stage_t stage = s_stage;
+    if (stage == POWER_IDLE_STAGE_ACTIVE) {
+        return;
+    }
+
+    idle_set_stage(POWER_IDLE_STAGE_ACTIVE);
+    s_rtc_idle.deep_sleep_wall_us = 0;
+    if (stage == POWER_IDLE_STAGE_DIM) {
+        pm_brightness_apply_current();
+    } else {
+        power_manager_exit_monitoring();
+    }
+}
+
+power_idle_stage_t power_manager_get_idle_stage(void)
+{
+    return s_stage;
+}
+
+esp_err_t power_manager_get_idle_thresholds(bool charging, power_idle_thresholds_t* out_thresholds)
+{
+    if (!out_thresholds) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *out_thresholds = charging ? s_ladder.charging : s_ladder.battery;
+    return ESP_OK;
+}
+
+esp_err_t power_manager_set_idle_thresholds(bool charging, const power_idle_thresholds_t* thresholds)
+{
+    if (!thresholds || !idle_thresholds_valid(thresholds)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (charging) {
+        s_ladder.charging = *thresholds;
+    } else {
+        s_ladder.battery = *thresholds;
+    }
+
+    idle_save_blob(IDLE_NVS_KEY_LADDER, &s_ladder, sizeof(s_ladder));
+    return ESP_OK;
+}
+
+void power_manager_get_idle_stats(uint64_t out_stage_s[POWER_IDLE_STAGE_COUNT])
+{
+    if (!out_stage_s) {
+        return;
+    }
+
+    idle_account_stage();
+    memcpy(out_stage_s, s_stats.stage_s, sizeof(s_stats.stage_s));
+}
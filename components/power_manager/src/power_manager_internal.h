@@ -1,11 +1,35 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stdint.h>
 #include "power_manager.h"
 
 extern power_manager_config_t s_pm_config;
 extern bool s_is_monitoring;
 
 void pm_battery_init(void);
+bool pm_battery_is_charging(void);
 void pm_brightness_init(void);
 void pm_brightness_apply_current(void);
+
+void pm_idle_init(void);
+/*
+ * Book idle time before any deep sleep. With @p monitoring, returns true once
+ * the ladder's deep sleep threshold has passed and the timer wake should go.
+ */
+bool pm_idle_before_deep_sleep(bool monitoring);
+/* Last ladder stage: display off, sensor stopped, button-only deep sleep. Does not return. */
+void pm_idle_deep_sleep(void);
+
+/* Apply the CPU ceiling for the current mode (active, monitoring, charging). */
+void pm_cpu_profile_update(void);
+
+void pm_soc_init(void);
+/* Load-compensated percent for one battery reading; also feeds curve learning. */
+int pm_soc_update(int batt_mv, bool charging, int64_t now_us);
+/* Terminal voltage plus the estimated load sag, regardless of charging state. */
+float pm_soc_compensate_mv(float batt_mv);
+/* Board current with the CPU active at this frequency, from the load model. */
+float pm_soc_cpu_current_ma(uint32_t cpu_mhz);
+void pm_soc_reset_filter(void);
+void pm_soc_on_shutdown(void);
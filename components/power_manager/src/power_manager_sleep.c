@@ -1,17 +1,40 @@
 #include "power_manager_internal.h"
 
 #include "bme680_sensor.h"
+#include "display_lvgl.h"
 #include "driver/gpio.h"
+#include "esp_attr.h"
 #include "esp_log.h"
 #include "esp_lvgl_port.h"
 #include "esp_sleep.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "settings.h"
 #include "ui.h"
 
 static const char* TAG = "power_mgr";
 
 #define WAKEUP_GPIO GPIO_NUM_0
+#define DISPLAY_FADE_OUT_MS 400
+#define DISPLAY_FADE_IN_MS 250
+/* Extra time for the last LEDC fade step before the panel is switched off. */
+#define DISPLAY_FADE_MARGIN_MS 30
+#define PANEL_OFF_TASK_STACK_SIZE 3072
+#define PANEL_OFF_TASK_PRIORITY 2
+
+static esp_timer_handle_t s_panel_off_timer;
+/* Switches the panel off; the timer only wakes it, as the panel sleep sequence delays for up to ~125 ms. */
+static TaskHandle_t s_panel_off_task;
+#if CONFIG_PM_AMBIENT_MODE
+static esp_timer_handle_t s_ambient_timer;
+#endif
+#if CONFIG_PM_DEEP_SLEEP_MONITORING
+/* Shortest timer sleep worth the reboot; a sample due sooner than this is simply taken late. */
+#define DEEP_MONITORING_MIN_SLEEP_US (1000ULL * 1000ULL)
+/* Set while deep-sleeping between monitoring samples, so a timer wake takes the fast path. */
+static RTC_DATA_ATTR bool s_rtc_deep_monitoring;
+#endif
 
 static void display_power_down(void)
 {
@@ -19,20 +42,178 @@ static void display_power_down(void)
         backlight_set_brightness(s_pm_config.bl_handle, 0);
     }
 
-    if (s_pm_config.panel_handle) {
-        esp_lcd_panel_disp_on_off(s_pm_config.panel_handle, false);
+    if (s_pm_config.display) {
+        display_lvgl_sleep(s_pm_config.display);
+    }
+}
+
+static void panel_off_timer_cb(void* arg)
+{
+    (void)arg;
+    xTaskNotifyGive(s_panel_off_task);
+}
+
+static void panel_off_task(void* arg)
+{
+    (void)arg;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        /* Checked under the LVGL lock so a wake that raced the timer wins. */
+        if (!lvgl_port_lock(100)) {
+            ESP_LOGW(TAG, "Panel off skipped: LVGL lock timeout");
+            continue;
+        }
+        if (s_is_monitoring && s_pm_config.display) {
+            display_lvgl_sleep(s_pm_config.display);
+        }
+        lvgl_port_unlock();
+    }
+}
+
+static void display_fade_out(void)
+{
+    if (!s_pm_config.bl_handle || backlight_fade_to(s_pm_config.bl_handle, 0, DISPLAY_FADE_OUT_MS) != ESP_OK) {
+        display_power_down();
+        return;
+    }
+
+    if (!s_panel_off_task &&
+        xTaskCreate(panel_off_task,
+            "panel_off",
+            PANEL_OFF_TASK_STACK_SIZE,
+            NULL,
+            PANEL_OFF_TASK_PRIORITY,
+            &s_panel_off_task) != pdPASS) {
+        s_panel_off_task = NULL;
+    }
+    if (s_panel_off_task && !s_panel_off_timer) {
+        const esp_timer_create_args_t args = {
+            .callback = panel_off_timer_cb,
+            .name = "panel_off",
+        };
+        if (esp_timer_create(&args, &s_panel_off_timer) != ESP_OK) {
+            s_panel_off_timer = NULL;
+        }
+    }
+
+    esp_err_t ret = ESP_FAIL;
+    if (s_panel_off_timer) {
+        esp_timer_stop(s_panel_off_timer);
+        ret = esp_timer_start_once(s_panel_off_timer, (DISPLAY_FADE_OUT_MS + DISPLAY_FADE_MARGIN_MS) * 1000ULL);
+    }
+    if (ret != ESP_OK && s_pm_config.display) {
+        display_lvgl_sleep(s_pm_config.display);
+    }
+}
+
+static void display_fade_in(void)
+{
+    int64_t start_us = esp_timer_get_time();
+
+    if (s_panel_off_timer) {
+        esp_timer_stop(s_panel_off_timer);
+    }
+
+    if (s_pm_config.display) {
+        esp_err_t ret = display_lvgl_wake(s_pm_config.display);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Display wake failed: %s", esp_err_to_name(ret));
+        }
+    }
+
+    /* Backlight is still off: bring values up to date and put them on the glass first. */
+    if (s_pm_config.on_display_refresh) {
+        s_pm_config.on_display_refresh();
+    }
+    uint32_t render_us = display_lvgl_render_now();
+    int64_t frame_ready_us = esp_timer_get_time();
+
+    if (s_pm_config.bl_handle) {
+        backlight_fade_to(s_pm_config.bl_handle, power_manager_get_active_brightness(), DISPLAY_FADE_IN_MS);
     }
+
+    ESP_LOGI(TAG,
+        "Wake to first correct frame: %lu us (render+flush %lu us)",
+        (unsigned long)(frame_ready_us - start_us),
+        (unsigned long)render_us);
 }
 
-static void display_power_up(void)
+#if CONFIG_PM_AMBIENT_MODE
+static void ambient_timer_cb(void* arg)
 {
-    if (s_pm_config.panel_handle) {
-        esp_lcd_panel_disp_on_off(s_pm_config.panel_handle, true);
+    (void)arg;
+
+    if (!lvgl_port_lock(100)) {
+        return;
+    }
+    if (s_is_monitoring) {
+        if (s_pm_config.on_display_refresh) {
+            s_pm_config.on_display_refresh();
+        }
+        /* Only labels whose text changed are invalidated, so this flushes a small window or nothing. */
+        display_lvgl_render_now();
     }
+    lvgl_port_unlock();
+}
+
+static void ambient_enter(void)
+{
+    lvgl_port_lock(0);
+    ui_show_ambient();
+    display_lvgl_render_now();
+    /* Rendering from here on happens only in ambient_timer_cb. */
+    lvgl_port_stop();
+    lvgl_port_unlock();
 
     if (s_pm_config.bl_handle) {
-        backlight_set_brightness(s_pm_config.bl_handle, power_manager_get_active_brightness());
+        backlight_fade_to(s_pm_config.bl_handle, CONFIG_PM_AMBIENT_BRIGHTNESS_PCT, DISPLAY_FADE_OUT_MS);
+    }
+
+    if (!s_ambient_timer) {
+        const esp_timer_create_args_t args = {
+            .callback = ambient_timer_cb,
+            .name = "ambient",
+        };
+        if (esp_timer_create(&args, &s_ambient_timer) != ESP_OK) {
+            s_ambient_timer = NULL;
+            ESP_LOGW(TAG, "Ambient update timer unavailable");
+            return;
+        }
+    }
+    esp_timer_start_periodic(s_ambient_timer, (uint64_t)CONFIG_PM_AMBIENT_UPDATE_PERIOD_S * 1000000ULL);
+}
+
+static void ambient_exit(void)
+{
+    if (s_ambient_timer) {
+        esp_timer_stop(s_ambient_timer);
+    }
+
+    lvgl_port_lock(0);
+    lvgl_port_resume();
+    if (ui_get_current_screen() == SCREEN_ID_AMBIENT) {
+        ui_hide_special();
     }
+    lvgl_port_unlock();
+}
+#endif
+
+static void deep_sleep_until_button(void)
+{
+    pm_soc_on_shutdown();
+    if (s_pm_config.on_deep_sleep) {
+        s_pm_config.on_deep_sleep();
+    }
+    (void)settings_flush();
+
+    // Ensure deep sleep wakeup sources are deterministic: button only.
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_ALL);
+    esp_sleep_enable_ext0_wakeup(WAKEUP_GPIO, 0);
+    bme680_sensor_deinit();
+
+    ESP_LOGI(TAG, "Entering deep sleep. Press button to wake up.");
+    esp_deep_sleep_start();
 }
 
 void power_manager_shutdown(void)
@@ -46,26 +227,89 @@ void power_manager_shutdown(void)
 
     vTaskDelay(pdMS_TO_TICKS(500));
     display_power_down();
+    deep_sleep_until_button();
+}
 
-    // Ensure deep sleep wakeup sources are deterministic: button only.
+void pm_idle_deep_sleep(void)
+{
+    if (s_panel_off_timer) {
+        esp_timer_stop(s_panel_off_timer);
+    }
+    if (s_pm_config.display) {
+        lvgl_port_lock(0);
+        display_power_down();
+        lvgl_port_unlock();
+    }
+
+    (void)pm_idle_before_deep_sleep(false);
+    deep_sleep_until_button();
+}
+
+#if CONFIG_PM_DEEP_SLEEP_MONITORING
+void power_manager_enter_deep_monitoring(uint64_t sleep_us)
+{
+    if (s_panel_off_timer) {
+        esp_timer_stop(s_panel_off_timer);
+    }
+    if (s_pm_config.display) {
+        lvgl_port_lock(0);
+        display_power_down();
+        lvgl_port_unlock();
+    }
+
+    if (pm_idle_before_deep_sleep(true)) {
+        /* Idle long enough for the last ladder stage: stop sampling, button wake only. */
+        s_rtc_deep_monitoring = false;
+        deep_sleep_until_button();
+    }
+
+    if (s_pm_config.on_deep_sleep) {
+        s_pm_config.on_deep_sleep();
+    }
+    (void)settings_flush();
+    (void)bme680_sensor_suspend();
+
+    if (sleep_us < DEEP_MONITORING_MIN_SLEEP_US) {
+        sleep_us = DEEP_MONITORING_MIN_SLEEP_US;
+    }
+    s_rtc_deep_monitoring = true;
     esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_ALL);
     esp_sleep_enable_ext0_wakeup(WAKEUP_GPIO, 0);
-    bme680_sensor_deinit();
+    esp_sleep_enable_timer_wakeup(sleep_us);
 
-    ESP_LOGI(TAG, "Entering deep sleep. Press button to wake up.");
+    ESP_LOGI(TAG, "Deep sleep for %llu ms until the next sample", (unsigned long long)(sleep_us / 1000ULL));
     esp_deep_sleep_start();
 }
 
+bool power_manager_is_deep_monitoring_wake(void)
+{
+    bool resume = s_rtc_deep_monitoring && (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER);
+    if (!resume) {
+        s_rtc_deep_monitoring = false;
+    }
+    return resume;
+}
+#endif
+
 void power_manager_enter_monitoring(void)
 {
     ESP_LOGI(TAG, "Entering monitoring mode...");
     s_is_monitoring = true;
-    display_power_down();
+    pm_cpu_profile_update();
+#if CONFIG_PM_AMBIENT_MODE
+    ambient_enter();
+#else
+    display_fade_out();
+#endif
 }
 
 void power_manager_exit_monitoring(void)
 {
     ESP_LOGI(TAG, "Exiting monitoring mode...");
     s_is_monitoring = false;
-    display_power_up();
+    pm_cpu_profile_update();
+#if CONFIG_PM_AMBIENT_MODE
+    ambient_exit();
+#endif
+    display_fade_in();
 }
@@ -0,0 +1,369 @@
+#include "power_manager_internal.h"
+
+#include <string.h>
+
+#include "display_lvgl.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "settings.h"
+
+static const char* TAG = "power_mgr";
+
+/*
+ * State of charge from the open-circuit voltage: the terminal voltage sags by
+ * I * R_int under load, so the estimated load current is added back before the
+ * voltage is mapped to percent. The OCV -> percent curve starts from a generic
+ * LiPo table and is relearned on every full discharge by integrating the load
+ * model over OCV bins. Every update is O(1) apart from fixed-size loops.
+ */
+
+/* Load model, in mA, for the T-Display board running from the battery. */
+#define SOC_LOAD_BASE_MA 20.0f
+#define SOC_LOAD_CPU_MA_PER_MHZ 0.1f
+#define SOC_LOAD_PANEL_MA 6.0f
+#define SOC_LOAD_BACKLIGHT_FULL_MA 30.0f
+#define SOC_LOAD_HEATER_MA 12.0f
+/* Average draw while the battery is not being read (monitoring); used for gaps. */
+#define SOC_LOAD_IDLE_MA 8.0f
+#define SOC_MAX_GAP_US (10LL * 1000000LL)
+
+/* Cell + protection + wiring; refined from voltage steps at load changes. */
+#define SOC_R_INT_DEFAULT_MOHM 250U
+#define SOC_R_INT_MIN_MOHM 50.0f
+#define SOC_R_INT_MAX_MOHM 1000.0f
+#define SOC_R_INT_ALPHA 0.2f
+#define SOC_R_STEP_MIN_MA 15.0f
+#define SOC_OCV_FILTER_ALPHA 0.3f
+
+#define SOC_CURVE_POINTS 11U /* 0, 10, ... 100 % */
+#define SOC_CURVE_MAX_WEIGHT 4U
+
+/* Learning: charge drawn per 25 mV OCV bin over one full-to-empty discharge. */
+#define SOC_BIN_MIN_MV 3200
+#define SOC_BIN_MV 25
+#define SOC_BINS 40U
+#define SOC_CYCLE_START_MV 4100
+#define SOC_CYCLE_END_MV 3350
+/* A learned cycle must cover at least 100 mAh to be trusted. */
+#define SOC_CYCLE_MIN_MAS (100UL * 3600UL)
+#define SOC_PERSIST_PERIOD_US (10LL * 60LL * 1000000LL)
+
+#define SOC_NVS_NAMESPACE "battery"
+#define SOC_NVS_KEY_CURVE "soc_curve"
+#define SOC_NVS_KEY_LEARN "soc_learn"
+#define SOC_RECORD_VERSION 1U
+
+typedef struct {
+    uint16_t version;
+    uint16_t cycles;
+    uint16_t r_int_mohm;
+    uint16_t ocv_mv[SOC_CURVE_POINTS];
+} soc_curve_record_t;
+
+typedef struct {
+    uint16_t version;
+    uint16_t active;
+    uint32_t total_mas;
+    uint32_t bin_mas[SOC_BINS];
+} soc_learn_record_t;
+
+static const uint16_t soc_default_curve[SOC_CURVE_POINTS] = {
+    3200, 3500, 3600, 3667, 3733, 3800, 3867, 3933, 4000, 4083, 4200};
+
+static soc_curve_record_t s_curve;
+static soc_learn_record_t s_learn;
+static float s_r_int_mohm = (float)SOC_R_INT_DEFAULT_MOHM;
+static uint16_t s_heater_duty_permille = 0;
+static bool s_ocv_valid = false;
+static float s_ocv_mv = 0.0f;
+static bool s_last_valid = false;
+static float s_last_mv = 0.0f;
+static float s_last_load_ma = 0.0f;
+static int64_t s_last_us = 0;
+static int64_t s_last_persist_us = 0;
+static float s_frac_mas = 0.0f;
+
+static bool soc_load_blob(const char* key, void* out, size_t size)
+{
+    return settings_get_blob(SOC_NVS_NAMESPACE, key, out, size) == ESP_OK;
+}
+
+static void soc_save_blob(const char* key, const void* data, size_t size)
+{
+    esp_err_t ret = settings_set_blob(SOC_NVS_NAMESPACE, key, data, size);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to persist %s: %s", key, esp_err_to_name(ret));
+    }
+}
+
+static bool soc_curve_is_sane(const soc_curve_record_t* curve)
+{
+    if (curve->version != SOC_RECORD_VERSION) {
+        return false;
+    }
+    for (size_t i = 1; i < SOC_CURVE_POINTS; i++) {
+        if (curve->ocv_mv[i] <= curve->ocv_mv[i - 1]) {
+            return false;
+        }
+    }
+    return curve->ocv_mv[0] >= 3000 && curve->ocv_mv[SOC_CURVE_POINTS - 1] <= 4400;
+}
+
+static int soc_percent_from_ocv(float ocv_mv)
+{
+    const uint16_t* mv = s_curve.ocv_mv;
+    if (ocv_mv <= mv[0]) {
+        return 0;
+    }
+    if (ocv_mv >= mv[SOC_CURVE_POINTS - 1]) {
+        return 100;
+    }
+
+    size_t i = 1;
+    while (i < SOC_CURVE_POINTS - 1 && ocv_mv > mv[i]) {
+        i++;
+    }
+    float span = (float)(mv[i] - mv[i - 1]);
+    float pct = 10.0f * (float)(i - 1) + 10.0f * (ocv_mv - (float)mv[i - 1]) / span;
+    return (int)(pct + 0.5f);
+}
+
+float pm_soc_cpu_current_ma(uint32_t cpu_mhz)
+{
+    return SOC_LOAD_BASE_MA + SOC_LOAD_CPU_MA_PER_MHZ * (float)cpu_mhz;
+}
+
+static float soc_estimate_load_ma(void)
+{
+    float load = pm_soc_cpu_current_ma(esp_rom_get_cpu_ticks_per_us());
+
+    if (!display_lvgl_is_asleep()) {
+        load += SOC_LOAD_PANEL_MA;
+    }
+
+    const backlight_handle_t* bl = s_pm_config.bl_handle;
+    if (bl && bl->duty > 0) {
+        /* Live LEDC duty, so a fade in progress is accounted for as it is. */
+        uint32_t duty = backlight_get_duty(bl);
+        load += SOC_LOAD_BACKLIGHT_FULL_MA * (float)duty / (float)bl->duty;
+    }
+
+    load += SOC_LOAD_HEATER_MA * (float)s_heater_duty_permille / 1000.0f;
+    return load;
+}
+
+static void soc_learn_reset(bool active)
+{
+    memset(&s_learn, 0, sizeof(s_learn));
+    s_learn.version = SOC_RECORD_VERSION;
+    s_learn.active = active ? 1U : 0U;
+    s_frac_mas = 0.0f;
+}
+
+static void soc_learn_finish(void)
+{
+    if (s_learn.total_mas < SOC_CYCLE_MIN_MAS) {
+        ESP_LOGI(TAG, "Discharge cycle too short to learn from (%lu mAh)", (unsigned long)(s_learn.total_mas / 3600U));
+        soc_learn_reset(false);
+        soc_save_blob(SOC_NVS_KEY_LEARN, &s_learn, sizeof(s_learn));
+        return;
+    }
+
+    /* Walk up from empty: the charge left at a bin's lower edge is everything drawn below it. */
+    uint16_t learned[SOC_CURVE_POINTS];
+    uint32_t below = 0;
+    size_t point = 0;
+    for (size_t bin = 0; bin < SOC_BINS && point < SOC_CURVE_POINTS; bin++) {
+        if (s_learn.bin_mas[bin] == 0) {
+            continue;
+        }
+        uint32_t above = below + s_learn.bin_mas[bin];
+        while (point < SOC_CURVE_POINTS) {
+            uint32_t target = (uint32_t)(((uint64_t)s_learn.total_mas * point) / (SOC_CURVE_POINTS - 1U));
+            if (target > above) {
+                break;
+            }
+            uint32_t in_bin = (target - below) * (uint32_t)SOC_BIN_MV / s_learn.bin_mas[bin];
+            learned[point++] = (uint16_t)(SOC_BIN_MIN_MV + (int)bin * SOC_BIN_MV + (int)in_bin);
+        }
+        below = above;
+    }
+    while (point < SOC_CURVE_POINTS) {
+        learned[point++] = (uint16_t)(SOC_BIN_MIN_MV + (int)SOC_BINS * SOC_BIN_MV);
+    }
+
+    soc_curve_record_t next = s_curve;
+    uint32_t weight = (s_curve.cycles < SOC_CURVE_MAX_WEIGHT) ? s_curve.cycles : SOC_CURVE_MAX_WEIGHT;
+    for (size_t i = 0; i < SOC_CURVE_POINTS; i++) {
+        next.ocv_mv[i] = (uint16_t)((s_curve.ocv_mv[i] * weight + learned[i] + weight / 2U) / (weight + 1U));
+    }
+    next.cycles = (uint16_t)(s_curve.cycles + 1U);
+    next.r_int_mohm = (uint16_t)(s_r_int_mohm + 0.5f);
+
+    if (soc_curve_is_sane(&next)) {
+        s_curve = next;
+        soc_save_blob(SOC_NVS_KEY_CURVE, &s_curve, sizeof(s_curve));
+        ESP_LOGI(TAG,
+            "Learned discharge curve #%u from %lu mAh: 10%%=%u mV, 50%%=%u mV, 90%%=%u mV",
+            (unsigned int)s_curve.cycles,
+            (unsigned long)(s_learn.total_mas / 3600U),
+            (unsigned int)s_curve.ocv_mv[1],
+            (unsigned int)s_curve.ocv_mv[5],
+            (unsigned int)s_curve.ocv_mv[9]);
+    } else {
+        ESP_LOGW(TAG, "Discarded non-monotonic learned discharge curve");
+    }
+
+    soc_learn_reset(false);
+    soc_save_blob(SOC_NVS_KEY_LEARN, &s_learn, sizeof(s_learn));
+}
+
+static void soc_learn_step(float ocv_mv, bool charging, float load_ma, int64_t dt_us, int64_t now_us)
+{
+    if (charging) {
+        if (s_learn.active) {
+            /* A top-up in the middle breaks the cycle; start over from the next full charge. */
+            soc_learn_reset(false);
+            soc_save_blob(SOC_NVS_KEY_LEARN, &s_learn, sizeof(s_learn));
+        }
+        return;
+    }
+
+    if (!s_learn.active) {
+        if (ocv_mv >= SOC_CYCLE_START_MV) {
+            soc_learn_reset(true);
+            s_last_persist_us = now_us;
+            ESP_LOGI(TAG, "Discharge cycle learning started at %d mV", (int)ocv_mv);
+        }
+        return;
+    }
+
+    int64_t active_us = (dt_us > SOC_MAX_GAP_US) ? SOC_MAX_GAP_US : dt_us;
+    float mas = load_ma * (float)active_us / 1000000.0f + SOC_LOAD_IDLE_MA * (float)(dt_us - active_us) / 1000000.0f;
+    s_frac_mas += mas;
+    uint32_t whole = (uint32_t)s_frac_mas;
+    s_frac_mas -= (float)whole;
+
+    int bin = ((int)ocv_mv - SOC_BIN_MIN_MV) / SOC_BIN_MV;
+    if (bin < 0) {
+        bin = 0;
+    } else if (bin >= (int)SOC_BINS) {
+        bin = (int)SOC_BINS - 1;
+    }
+    s_learn.bin_mas[bin] += whole;
+    s_learn.total_mas += whole;
+
+    if (ocv_mv <= SOC_CYCLE_END_MV) {
+        soc_learn_finish();
+        return;
+    }
+
+    if ((now_us - s_last_persist_us) >= SOC_PERSIST_PERIOD_US) {
+        s_last_persist_us = now_us;
+        soc_save_blob(SOC_NVS_KEY_LEARN, &s_learn, sizeof(s_learn));
+    }
+}
+
+static void soc_update_r_int(float batt_mv, float load_ma, int64_t dt_us)
+{
+    if (!s_last_valid || dt_us > SOC_MAX_GAP_US) {
+        return;
+    }
+
+    float d_load = load_ma - s_last_load_ma;
+    if (d_load < SOC_R_STEP_MIN_MA && d_load > -SOC_R_STEP_MIN_MA) {
+        return;
+    }
+
+    /* mV per mA is ohms; a load step pulls the terminal voltage the other way. */
+    float r_mohm = -1000.0f * (batt_mv - s_last_mv) / d_load;
+    if (r_mohm < SOC_R_INT_MIN_MOHM || r_mohm > SOC_R_INT_MAX_MOHM) {
+        return;
+    }
+    s_r_int_mohm += SOC_R_INT_ALPHA * (r_mohm - s_r_int_mohm);
+}
+
+void pm_soc_init(void)
+{
+    if (soc_load_blob(SOC_NVS_KEY_CURVE, &s_curve, sizeof(s_curve)) && soc_curve_is_sane(&s_curve)) {
+        if (s_curve.r_int_mohm >= SOC_R_INT_MIN_MOHM && s_curve.r_int_mohm <= SOC_R_INT_MAX_MOHM) {
+            s_r_int_mohm = (float)s_curve.r_int_mohm;
+        }
+        ESP_LOGI(TAG,
+            "Battery curve learned over %u cycles, R_int=%u mOhm",
+            (unsigned int)s_curve.cycles,
+            (unsigned int)s_r_int_mohm);
+    } else {
+        memset(&s_curve, 0, sizeof(s_curve));
+        s_curve.version = SOC_RECORD_VERSION;
+        s_curve.r_int_mohm = SOC_R_INT_DEFAULT_MOHM;
+        memcpy(s_curve.ocv_mv, soc_default_curve, sizeof(s_curve.ocv_mv));
+    }
+
+    if (!soc_load_blob(SOC_NVS_KEY_LEARN, &s_learn, sizeof(s_learn)) || s_learn.version != SOC_RECORD_VERSION) {
+        soc_learn_reset(false);
+    }
+}
+
+int pm_soc_update(int batt_mv, bool charging, int64_t now_us)
+{
+    float load_ma = soc_estimate_load_ma();
+    int64_t dt_us = s_last_valid ? (now_us - s_last_us) : 0;
+
+    if (!charging) {
+        soc_update_r_int((float)batt_mv, load_ma, dt_us);
+    }
+
+    /* While charging the current flows the other way and is unknown; use the terminal voltage as is. */
+    float ocv = (float)batt_mv;
+    if (!charging) {
+        ocv += load_ma * s_r_int_mohm / 1000.0f;
+    }
+    if (!s_ocv_valid) {
+        s_ocv_mv = ocv;
+        s_ocv_valid = true;
+    } else {
+        s_ocv_mv += SOC_OCV_FILTER_ALPHA * (ocv - s_ocv_mv);
+    }
+
+    if (s_last_valid) {
+        soc_learn_step(s_ocv_mv, charging, load_ma, dt_us, now_us);
+    }
+
+    s_last_valid = true;
+    s_last_mv = (float)batt_mv;
+    s_last_load_ma = load_ma;
+    s_last_us = now_us;
+
+    return soc_percent_from_ocv(s_ocv_mv);
+}
+
+float pm_soc_compensate_mv(float batt_mv)
+{
+    return batt_mv + soc_estimate_load_ma() * s_r_int_mohm / 1000.0f;
+}
+
+void pm_soc_reset_filter(void)
+{
+    s_ocv_valid = false;
+    s_last_valid = false;
+}
+
+void pm_soc_on_shutdown(void)
+{
+    if (!s_learn.active) {
+        return;
+    }
+
+    /* A low-battery shutdown is the end of the discharge as far as the device is concerned. */
+    if (s_ocv_valid && s_ocv_mv <= (float)s_curve.ocv_mv[1]) {
+        soc_learn_finish();
+    } else {
+        soc_save_blob(SOC_NVS_KEY_LEARN, &s_learn, sizeof(s_learn));
+    }
+}
+
+void power_manager_set_heater_duty(uint16_t duty_permille)
+{
+    s_heater_duty_permille = (duty_permille > 1000U) ? 1000U : duty_permille;
+}
@@ -0,0 +1,342 @@
+/*
+ * Host test for the charger detection in src/power_manager_charge.c.
+ *
+ * Replays the voltage traces in traces/ through the detector on the same
+ * schedule as the device: one burst every BATTERY_UPDATE_INTERVAL_MS, picked
+ * up by the 100 ms sensor loop, and a fast series of BATTERY_FAST_BURSTS after
+ * a step. Each trace runs under many seeds, each with its own read phase and
+ * burst noise, and the test fails on a missed or late detection or on any
+ * state change that no plug/unplug in the trace explains.
+ *
+ * Trace format: "t_ms,mv" rows of the load-compensated voltage, linearly
+ * interpolated; two rows with the same time are a step. Comment lines set the
+ * initial state ("# initial battery|charging") and the expected events
+ * ("# expect plug|unplug <t_ms>").
+ */
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "power_manager_charge.h"
+
+/* Device schedule, as in main.c and power_manager_battery.c. */
+#define READ_INTERVAL_US 2000000LL
+#define LOOP_US 100000LL
+#define BURST_US 10000LL /* settle + 16 samples 500 us apart */
+#define NOISE_MV 2.0
+#define SEEDS 2000U
+/* One read interval, the fast series and the loop pickup. */
+#define MAX_LATENCY_MS 2600
+
+#define MAX_POINTS 64U
+#define MAX_EVENTS 8U
+
+typedef struct {
+    int64_t t_ms;
+    bool charging;
+} trace_event_t;
+
+typedef struct {
+    const char* name;
+    uint32_t count;
+    int64_t t_ms[MAX_POINTS];
+    double mv[MAX_POINTS];
+    bool initial_charging;
+    uint32_t event_count;
+    trace_event_t events[MAX_EVENTS];
+} trace_t;
+
+typedef struct {
+    uint32_t runs;
+    uint32_t missed;
+    uint32_t false_positives;
+    int64_t latency_max_ms;
+    int64_t latency_sum_ms;
+    uint32_t latency_count;
+} trace_stats_t;
+
+static uint32_t s_failures;
+
+#define CHECK(cond, ...)                                                                                                \
+    do {                                                                                                                \
+        if (!(cond)) {                                                                                                  \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__);                                                                 \
+            printf(__VA_ARGS__);                                                                                        \
+            printf("\n");                                                                                               \
+            s_failures++;                                                                                               \
+        }                                                                                                               \
+    } while (0)
+
+static uint64_t s_rng;
+
+static double rng_uniform(void)
+{
+    /* xorshift64*, so every platform replays the same noise. */
+    s_rng ^= s_rng >> 12;
+    s_rng ^= s_rng << 25;
+    s_rng ^= s_rng >> 27;
+    return (double)((s_rng * 2685821657736338717ULL) >> 11) / 9007199254740992.0;
+}
+
+static double rng_gauss(void)
+{
+    double u1 = rng_uniform();
+    double u2 = rng_uniform();
+    if (u1 < 1e-12) {
+        u1 = 1e-12;
+    }
+    return sqrt(-2.0 * log(u1)) * cos(6.283185307179586 * u2);
+}
+
+static bool trace_load(const char* path, trace_t* trace)
+{
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        printf("cannot open %s\n", path);
+        return false;
+    }
+
+    memset(trace, 0, sizeof(*trace));
+    const char* slash = strrchr(path, '/');
+    trace->name = slash ? slash + 1 : path;
+
+    char line[256];
+    char word[32];
+    long long t_ms = 0;
+    double mv = 0.0;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "# initial %31s", word) == 1) {
+            trace->initial_charging = (strcmp(word, "charging") == 0);
+        } else if (sscanf(line, "# expect %31s %lld", word, &t_ms) == 2 && trace->event_count < MAX_EVENTS) {
+            trace->events[trace->event_count].t_ms = t_ms;
+            trace->events[trace->event_count].charging = (strcmp(word, "plug") == 0);
+            trace->event_count++;
+        } else if (line[0] != '#' && sscanf(line, "%lld,%lf", &t_ms, &mv) == 2 && trace->count < MAX_POINTS) {
+            trace->t_ms[trace->count] = t_ms;
+            trace->mv[trace->count] = mv;
+            trace->count++;
+        }
+    }
+    fclose(f);
+
+    if (trace->count < 2) {
+        printf("%s: no samples\n", path);
+        return false;
+    }
+    return true;
+}
+
+static double trace_mv_at(const trace_t* trace, int64_t t_us)
+{
+    double t_ms = (double)t_us / 1000.0;
+    if (t_ms <= (double)trace->t_ms[0]) {
+        return trace->mv[0];
+    }
+    /* The last row at or before t wins, so a repeated time is a step. */
+    for (uint32_t i = trace->count - 1U; i > 0; i--) {
+        if ((double)trace->t_ms[i - 1U] <= t_ms) {
+            if (t_ms >= (double)trace->t_ms[i] || trace->t_ms[i] == trace->t_ms[i - 1U]) {
+                return trace->mv[i];
+            }
+            double f = (t_ms - (double)trace->t_ms[i - 1U]) / (double)(trace->t_ms[i] - trace->t_ms[i - 1U]);
+            return trace->mv[i - 1U] + f * (trace->mv[i] - trace->mv[i - 1U]);
+        }
+    }
+    return trace->mv[trace->count - 1U];
+}
+
+static float read_burst(const trace_t* trace, int64_t start_us)
+{
+    return (float)(trace_mv_at(trace, start_us + BURST_US) + rng_gauss() * NOISE_MV);
+}
+
+static void replay(const trace_t* trace, uint32_t seed, trace_stats_t* stats)
+{
+    s_rng = 0x9E3779B97F4A7C15ULL ^ ((uint64_t)seed * 0x100000001B3ULL);
+    (void)rng_uniform();
+
+    /* Start from a settled detector: a full window of readings before the trace, in its initial state. */
+    pm_charge_detect_t det;
+    pm_charge_init(&det);
+    det.charging = trace->initial_charging;
+    for (uint32_t i = BATTERY_SLOPE_WINDOW; i > 0; i--) {
+        int64_t prime_us = -(int64_t)i * READ_INTERVAL_US;
+        (void)pm_charge_push(&det, prime_us, (float)(trace->mv[0] + rng_gauss() * NOISE_MV));
+    }
+
+    int64_t end_us = trace->t_ms[trace->count - 1U] * 1000LL;
+    /* The sensor loop runs at an arbitrary phase against the trace. */
+    int64_t t_us = (int64_t)(rng_uniform() * (double)READ_INTERVAL_US);
+    uint32_t next_event = 0;
+    bool expected = trace->initial_charging;
+    bool detected = true;
+    int64_t event_us = 0;
+
+    while (t_us < end_us) {
+        int64_t result_us = t_us + LOOP_US;
+        float mv = read_burst(trace, t_us);
+        if (pm_charge_push(&det, t_us + BURST_US, mv)) {
+            int64_t burst_us = t_us + BURST_US;
+            for (uint32_t i = 0; i < BATTERY_FAST_BURSTS; i++) {
+                burst_us += BATTERY_FAST_GAP_US + BURST_US;
+                mv = read_burst(trace, burst_us - BURST_US);
+                (void)pm_charge_push(&det, burst_us, mv);
+            }
+            result_us = ((burst_us + LOOP_US - 1) / LOOP_US) * LOOP_US;
+        }
+
+        while (next_event < trace->event_count && trace->events[next_event].t_ms * 1000LL <= result_us) {
+            if (!detected) {
+                stats->missed++;
+            }
+            event_us = trace->events[next_event].t_ms * 1000LL;
+            expected = trace->events[next_event].charging;
+            detected = (det.charging == expected);
+            next_event++;
+        }
+
+        bool was_charging = det.charging;
+        bool charging = pm_charge_update(&det, (int)lroundf(mv), NULL);
+        if (charging != was_charging) {
+            if (!detected && charging == expected) {
+                int64_t latency_ms = (result_us - event_us) / 1000LL;
+                detected = true;
+                stats->latency_sum_ms += latency_ms;
+                stats->latency_count++;
+                if (latency_ms > stats->latency_max_ms) {
+                    stats->latency_max_ms = latency_ms;
+                }
+            } else {
+                stats->false_positives++;
+            }
+        }
+
+        t_us = result_us + READ_INTERVAL_US;
+    }
+
+    if (!detected || next_event < trace->event_count) {
+        stats->missed++;
+    }
+    stats->runs++;
+}
+
+static void test_trace(const char* path)
+{
+    trace_t trace;
+    if (!trace_load(path, &trace)) {
+        s_failures++;
+        return;
+    }
+
+    trace_stats_t stats = {0};
+    for (uint32_t seed = 0; seed < SEEDS; seed++) {
+        replay(&trace, seed, &stats);
+    }
+
+    printf("%-24s runs %u, events %u, missed %u, false positives %u, latency avg %lld ms max %lld ms\n",
+        trace.name,
+        stats.runs,
+        trace.event_count,
+        stats.missed,
+        stats.false_positives,
+        stats.latency_count ? (long long)(stats.latency_sum_ms / stats.latency_count) : 0LL,
+        (long long)stats.latency_max_ms);
+
+    CHECK(stats.missed == 0, "%s: %u missed detections", trace.name, stats.missed);
+    CHECK(stats.false_positives == 0, "%s: %u false positives", trace.name, stats.false_positives);
+    CHECK(stats.latency_max_ms <= MAX_LATENCY_MS,
+        "%s: latency %lld ms over %d ms",
+        trace.name,
+        (long long)stats.latency_max_ms,
+        MAX_LATENCY_MS);
+}
+
+/* Noise-free ramp read every 2 s from @p charging; returns the state after a full window. */
+static bool ramp_state(bool charging, float mv_per_s)
+{
+    pm_charge_detect_t det;
+    pm_charge_init(&det);
+    det.charging = charging;
+    for (uint32_t i = 0; i < BATTERY_SLOPE_WINDOW; i++) {
+        (void)pm_charge_push(&det, (int64_t)i * READ_INTERVAL_US, 3900.0f + mv_per_s * 2.0f * (float)i);
+    }
+    return pm_charge_update(&det, 3900, NULL);
+}
+
+static bool step_detected(float step_mv)
+{
+    pm_charge_detect_t det;
+    pm_charge_init(&det);
+    (void)pm_charge_push(&det, 0, 3900.0f);
+    return pm_charge_push(&det, READ_INTERVAL_US, 3900.0f + step_mv);
+}
+
+/* Step of @p step_mv from a settled window, followed by a fast series at @p after_mv; returns the state. */
+static bool step_state(float step_mv, float after_mv, uint32_t* out_count)
+{
+    pm_charge_detect_t det;
+    pm_charge_init(&det);
+    int64_t t_us = 0;
+    for (uint32_t i = 0; i < BATTERY_SLOPE_WINDOW; i++) {
+        (void)pm_charge_push(&det, t_us, 3900.0f);
+        t_us += READ_INTERVAL_US;
+    }
+    (void)pm_charge_push(&det, t_us, 3900.0f + step_mv);
+    for (uint32_t i = 0; i < BATTERY_FAST_BURSTS; i++) {
+        t_us += BATTERY_FAST_GAP_US;
+        (void)pm_charge_push(&det, t_us, 3900.0f + after_mv);
+    }
+    bool charging = pm_charge_update(&det, 3900, NULL);
+    *out_count = det.count;
+    return charging;
+}
+
+static void test_thresholds(void)
+{
+    uint32_t count = 0;
+    CHECK(!ramp_state(false, BATTERY_SLOPE_ON_MV_S - 0.1f), "turned on below the on slope");
+    CHECK(ramp_state(false, BATTERY_SLOPE_ON_MV_S + 0.1f), "stayed off above the on slope");
+    CHECK(ramp_state(true, BATTERY_SLOPE_OFF_MV_S + 0.1f), "turned off above the off slope");
+    CHECK(!ramp_state(true, BATTERY_SLOPE_OFF_MV_S - 0.1f), "stayed on below the off slope");
+    CHECK(ramp_state(true, 0.0f) && !ramp_state(false, 0.0f), "flat voltage changed the state");
+
+    CHECK(!step_detected(BATTERY_STEP_SUSPECT_MV - 0.5f), "step below the trigger");
+    CHECK(step_detected(BATTERY_STEP_SUSPECT_MV + 0.5f), "step above the trigger missed");
+    CHECK(!step_detected(-(BATTERY_STEP_SUSPECT_MV - 0.5f)), "negative step below the trigger");
+    CHECK(step_detected(-(BATTERY_STEP_SUSPECT_MV + 0.5f)), "negative step above the trigger missed");
+
+    /* A step the fast series confirms decides on its slope; one that falls back is dropped. */
+    CHECK(step_state(BATTERY_STEP_SUSPECT_MV + 10.0f, BATTERY_STEP_SUSPECT_MV + 10.0f, &count), "held step missed");
+    CHECK(!step_state(BATTERY_STEP_SUSPECT_MV + 10.0f, 0.0f, &count), "transient step taken as a plug");
+    CHECK(count == BATTERY_SLOPE_WINDOW + 1U, "transient left %u readings", count);
+    CHECK(!step_state(BATTERY_STEP_SUSPECT_MV + 10.0f, BATTERY_STEP_SUSPECT_MV - 5.0f, &count),
+        "step that fell back below the trigger taken as a plug");
+
+    /* After a gap the window restarts: no step, and only the absolute level counts. */
+    pm_charge_detect_t det;
+    pm_charge_init(&det);
+    (void)pm_charge_push(&det, 0, 3900.0f);
+    CHECK(!pm_charge_push(&det, BATTERY_SLOPE_MAX_GAP_US + 1, 4000.0f), "step across a gap");
+    CHECK(det.count == 1U, "window kept across a gap");
+    CHECK(pm_charge_update(&det, BATTERY_CHARGING_ABS_ON_MV, NULL), "absolute on level ignored");
+    CHECK(pm_charge_update(&det, BATTERY_CHARGING_ABS_OFF_MV + 50, NULL), "state not held between levels");
+    CHECK(!pm_charge_update(&det, BATTERY_CHARGING_ABS_OFF_MV, NULL), "absolute off level ignored");
+}
+
+int main(int argc, char** argv)
+{
+    test_thresholds();
+    for (int i = 1; i < argc; i++) {
+        test_trace(argv[i]);
+    }
+
+    if (s_failures) {
+        printf("%u check(s) failed\n", s_failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "bme680_sensor.h"
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Min/max/mean history of the BME680 readings at three resolutions. Every
+ * sample updates one running bucket per tier in O(1); a bucket is stored in
+ * its tier's ring when time moves past it. Readers get finished buckets
+ * without touching raw samples.
+ *
+ * The 15-minute and day tiers live in RTC memory and are indexed by system
+ * time, so they carry on through deep sleep and monitoring wakes; they start
+ * over on power-on and other resets. The minute tier is heap memory and
+ * starts over at every boot.
+ */
+
+/**
+ * @brief Bucket resolutions.
+ */
+typedef enum {
+    SENSOR_HISTORY_TIER_MINUTE = 0,
+    SENSOR_HISTORY_TIER_QUARTER_HOUR,
+    SENSOR_HISTORY_TIER_DAY,
+    SENSOR_HISTORY_TIER_COUNT,
+} sensor_history_tier_t;
+
+/**
+ * @brief Tracked values.
+ */
+typedef enum {
+    /**< Celsius. */
+    SENSOR_HISTORY_TEMPERATURE = 0,
+    /**< Percent relative humidity. */
+    SENSOR_HISTORY_HUMIDITY,
+    /**< Pascals. */
+    SENSOR_HISTORY_PRESSURE,
+    /**< Static IAQ; only samples with iaq_valid count. */
+    SENSOR_HISTORY_STATIC_IAQ,
+    /**< Ohms; the mean is the geometric mean. */
+    SENSOR_HISTORY_GAS_RESISTANCE,
+    SENSOR_HISTORY_METRIC_COUNT,
+} sensor_history_metric_t;
+
+/**
+ * @brief Aggregate of one value over one bucket.
+ */
+typedef struct {
+    float min;
+    float max;
+    float mean;
+    /**< Samples aggregated; 0 when the value was never valid in the bucket. */
+    uint16_t count;
+} sensor_history_stat_t;
+
+/**
+ * @brief One bucket, decoded.
+ *
+ * Values are stored with 0.01 C, 0.01 %RH, 10 Pa, 0.1 IAQ and 0.06 % gas
+ * resistance resolution.
+ */
+typedef struct {
+    /**< System time (gettimeofday(), counts through deep sleep) in microseconds where the bucket starts. */
+    int64_t start_us;
+    sensor_history_stat_t metrics[SENSOR_HISTORY_METRIC_COUNT];
+} sensor_history_bucket_t;
+
+/**
+ * @brief Allocate the minute ring (PSRAM first, when present).
+ *
+ * The RTC tiers need no init; call this after the display buffers are
+ * allocated, as it takes internal RAM on boards without PSRAM.
+ *
+ * @return ESP_OK, or ESP_ERR_NO_MEM; the minute tier then stays empty.
+ */
+esp_err_t sensor_history_init(void);
+
+/**
+ * @brief Add a sample to every tier.
+ *
+ * O(1). Works before sensor_history_init() for the RTC tiers, so the
+ * monitoring wake can feed them. Samples with a timestamp not newer than the
+ * last one are ignored.
+ */
+void sensor_history_add(const bme680_sensor_data_t* data);
+
+/**
+ * @brief Get a bucket by age.
+ *
+ * @param[in] tier Resolution.
+ * @param[in] age 0 for the bucket still being filled, 1 for the last finished one, and so on up to
+ *                sensor_history_get_capacity().
+ * @param[out] out_bucket Output bucket.
+ *
+ * @return true when the bucket holds at least one sample; false when it is empty, out of range or
+ *         already overwritten.
+ */
+bool sensor_history_get_bucket(sensor_history_tier_t tier, size_t age, sensor_history_bucket_t* out_bucket);
+
+/**
+ * @brief Finished buckets a tier keeps.
+ */
+size_t sensor_history_get_capacity(sensor_history_tier_t tier);
+
+/**
+ * @brief Bucket length of a tier in seconds.
+ */
+uint32_t sensor_history_get_bucket_s(sensor_history_tier_t tier);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,311 @@
+#include "sensor_history.h"
+
+#include <limits.h>
+#include <math.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+static const char* TAG = "sensor_history";
+
+/* Gas resistance is kept as log10(ohm) * GAS_LOG_SCALE: 1 ohm..10 Mohm in 0.06 % steps. */
+#define GAS_LOG_SCALE 4000.0f
+
+/*
+ * A finished bucket. The bucket number (bucket start / bucket length) tells
+ * whether a ring slot still holds the bucket a reader asks for, so skipped
+ * buckets never need to be written.
+ */
+typedef struct {
+    uint32_t index;
+    uint16_t count;
+    uint16_t iaq_count;
+    int16_t min[SENSOR_HISTORY_METRIC_COUNT];
+    int16_t max[SENSOR_HISTORY_METRIC_COUNT];
+    int16_t mean[SENSOR_HISTORY_METRIC_COUNT];
+} history_slot_t;
+
+/* The bucket being filled; 65535 samples of int16 still sum within int32, so the count caps the bucket. */
+typedef struct {
+    bool open;
+    uint32_t index;
+    uint16_t count;
+    uint16_t iaq_count;
+    int16_t min[SENSOR_HISTORY_METRIC_COUNT];
+    int16_t max[SENSOR_HISTORY_METRIC_COUNT];
+    int32_t sum[SENSOR_HISTORY_METRIC_COUNT];
+} history_acc_t;
+
+typedef struct {
+    uint32_t bucket_s;
+    size_t len;
+    history_slot_t* slots;
+    history_acc_t* acc;
+} history_tier_t;
+
+/*
+ * The quarter-hour and day tiers live in RTC memory, so they are kept through
+ * deep sleep (monitoring included) and need no allocation; they start over on
+ * power-on and on any other reset. The minute tier is allocated on the heap
+ * by sensor_history_init() and is lost in deep sleep.
+ */
+static RTC_DATA_ATTR history_slot_t s_rtc_quarter_hour_slots[CONFIG_SENSOR_HISTORY_QUARTER_HOUR_BUCKETS];
+static RTC_DATA_ATTR history_slot_t s_rtc_day_slots[CONFIG_SENSOR_HISTORY_DAY_BUCKETS];
+static RTC_DATA_ATTR history_acc_t s_rtc_quarter_hour_acc;
+static RTC_DATA_ATTR history_acc_t s_rtc_day_acc;
+static history_acc_t s_minute_acc;
+
+static history_tier_t s_tiers[SENSOR_HISTORY_TIER_COUNT] = {
+    [SENSOR_HISTORY_TIER_MINUTE] = {.bucket_s = 60U, .len = CONFIG_SENSOR_HISTORY_MINUTE_BUCKETS, .acc = &s_minute_acc},
+    [SENSOR_HISTORY_TIER_QUARTER_HOUR] = {.bucket_s = 15U * 60U,
+        .len = CONFIG_SENSOR_HISTORY_QUARTER_HOUR_BUCKETS,
+        .slots = s_rtc_quarter_hour_slots,
+        .acc = &s_rtc_quarter_hour_acc},
+    [SENSOR_HISTORY_TIER_DAY] = {.bucket_s = 24U * 3600U,
+        .len = CONFIG_SENSOR_HISTORY_DAY_BUCKETS,
+        .slots = s_rtc_day_slots,
+        .acc = &s_rtc_day_acc},
+};
+/* Every update is a few dozen bytes, so a spinlock is enough and needs no init on the monitoring path. */
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static bool s_initialized;
+static int64_t s_last_sample_us = -1;
+
+/* System time of an esp_timer timestamp; unlike esp_timer it keeps counting through deep sleep. */
+static int64_t history_system_time_us(int64_t timestamp_us)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    int64_t now_us = (int64_t)tv.tv_sec * 1000000LL + tv.tv_usec;
+    return now_us - (esp_timer_get_time() - timestamp_us);
+}
+
+static int16_t history_encode_value(float value, float scale)
+{
+    float scaled = roundf(value * scale);
+    if (scaled > (float)INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (scaled < (float)INT16_MIN) {
+        return INT16_MIN;
+    }
+    return (int16_t)scaled;
+}
+
+static void history_encode(const bme680_sensor_data_t* data, int16_t out[SENSOR_HISTORY_METRIC_COUNT])
+{
+    out[SENSOR_HISTORY_TEMPERATURE] = history_encode_value(data->temperature_c, 100.0f);
+    out[SENSOR_HISTORY_HUMIDITY] = history_encode_value(data->humidity_rh, 100.0f);
+    out[SENSOR_HISTORY_PRESSURE] = history_encode_value(data->pressure_pa, 0.1f);
+    out[SENSOR_HISTORY_STATIC_IAQ] = history_encode_value((float)data->static_iaq, 10.0f);
+    float gas = (data->gas_resistance_ohm > 1.0f) ? data->gas_resistance_ohm : 1.0f;
+    out[SENSOR_HISTORY_GAS_RESISTANCE] = history_encode_value(log10f(gas), GAS_LOG_SCALE);
+}
+
+static float history_decode(sensor_history_metric_t metric, float value)
+{
+    switch (metric) {
+    case SENSOR_HISTORY_TEMPERATURE:
+    case SENSOR_HISTORY_HUMIDITY:
+        return value / 100.0f;
+    case SENSOR_HISTORY_PRESSURE:
+        return value * 10.0f;
+    case SENSOR_HISTORY_STATIC_IAQ:
+        return value / 10.0f;
+    case SENSOR_HISTORY_GAS_RESISTANCE:
+        return powf(10.0f, value / GAS_LOG_SCALE);
+    default:
+        return 0.0f;
+    }
+}
+
+static uint16_t history_metric_count(sensor_history_metric_t metric, uint16_t count, uint16_t iaq_count)
+{
+    return (metric == SENSOR_HISTORY_STATIC_IAQ) ? iaq_count : count;
+}
+
+static void history_close(history_tier_t* tier)
+{
+    history_acc_t* acc = tier->acc;
+    if (!acc->open || acc->count == 0U) {
+        return;
+    }
+
+    history_slot_t* slot = &tier->slots[acc->index % tier->len];
+    slot->index = acc->index;
+    slot->count = acc->count;
+    slot->iaq_count = acc->iaq_count;
+    for (int m = 0; m < SENSOR_HISTORY_METRIC_COUNT; m++) {
+        uint16_t n = history_metric_count((sensor_history_metric_t)m, acc->count, acc->iaq_count);
+        slot->min[m] = acc->min[m];
+        slot->max[m] = acc->max[m];
+        slot->mean[m] = n ? (int16_t)lroundf((float)acc->sum[m] / (float)n) : 0;
+    }
+}
+
+static void history_accumulate(history_acc_t* acc, const int16_t values[SENSOR_HISTORY_METRIC_COUNT], bool iaq_valid)
+{
+    if (acc->count == UINT16_MAX) {
+        return;
+    }
+    for (int m = 0; m < SENSOR_HISTORY_METRIC_COUNT; m++) {
+        if (m == SENSOR_HISTORY_STATIC_IAQ && !iaq_valid) {
+            continue;
+        }
+        uint16_t n = history_metric_count((sensor_history_metric_t)m, acc->count, acc->iaq_count);
+        if (n == 0U || values[m] < acc->min[m]) {
+            acc->min[m] = values[m];
+        }
+        if (n == 0U || values[m] > acc->max[m]) {
+            acc->max[m] = values[m];
+        }
+        acc->sum[m] += values[m];
+    }
+
+    acc->count++;
+    if (iaq_valid) {
+        acc->iaq_count++;
+    }
+}
+
+esp_err_t sensor_history_init(void)
+{
+    if (s_initialized) {
+        return ESP_OK;
+    }
+
+    history_tier_t* minute = &s_tiers[SENSOR_HISTORY_TIER_MINUTE];
+    history_slot_t* slots = heap_caps_calloc(minute->len, sizeof(history_slot_t), MALLOC_CAP_SPIRAM);
+    if (slots == NULL) {
+        slots = heap_caps_calloc(minute->len, sizeof(history_slot_t), MALLOC_CAP_8BIT);
+    }
+    if (slots == NULL) {
+        ESP_LOGE(TAG, "No memory for %u minute buckets", (unsigned int)minute->len);
+        return ESP_ERR_NO_MEM;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    minute->slots = slots;
+    portEXIT_CRITICAL(&s_lock);
+    s_initialized = true;
+
+    ESP_LOGI(TAG,
+        "History: %u x 1 min (%u bytes heap), %u x 15 min, %u x 1 day (%u bytes RTC)",
+        (unsigned int)minute->len,
+        (unsigned int)(minute->len * sizeof(history_slot_t)),
+        (unsigned int)s_tiers[SENSOR_HISTORY_TIER_QUARTER_HOUR].len,
+        (unsigned int)s_tiers[SENSOR_HISTORY_TIER_DAY].len,
+        (unsigned int)(sizeof(s_rtc_quarter_hour_slots) + sizeof(s_rtc_day_slots) + 2U * sizeof(history_acc_t)));
+    return ESP_OK;
+}
+
+void sensor_history_add(const bme680_sensor_data_t* data)
+{
+    if (data == NULL || data->timestamp_us <= s_last_sample_us) {
+        return;
+    }
+
+    int16_t values[SENSOR_HISTORY_METRIC_COUNT];
+    history_encode(data, values);
+    int64_t t_us = history_system_time_us(data->timestamp_us);
+    if (t_us < 0) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_last_sample_us = data->timestamp_us;
+    for (int t = 0; t < SENSOR_HISTORY_TIER_COUNT; t++) {
+        history_tier_t* tier = &s_tiers[t];
+        if (tier->slots == NULL) {
+            continue;
+        }
+        history_acc_t* acc = tier->acc;
+        uint32_t index = (uint32_t)(t_us / ((int64_t)tier->bucket_s * 1000000LL));
+        if (acc->open && index < acc->index) {
+            /* System time went back (set by hand); the stored buckets no longer line up. */
+            memset(tier->slots, 0, tier->len * sizeof(history_slot_t));
+            acc->open = false;
+        }
+        if (!acc->open || acc->index != index) {
+            history_close(tier);
+            memset(acc, 0, sizeof(*acc));
+            acc->open = true;
+            acc->index = index;
+        }
+        history_accumulate(acc, values, data->iaq_valid);
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+bool sensor_history_get_bucket(sensor_history_tier_t tier_id, size_t age, sensor_history_bucket_t* out_bucket)
+{
+    if (out_bucket == NULL || (unsigned int)tier_id >= SENSOR_HISTORY_TIER_COUNT) {
+        return false;
+    }
+
+    history_tier_t* tier = &s_tiers[tier_id];
+    uint32_t index = 0;
+    uint16_t count = 0;
+    uint16_t iaq_count = 0;
+    int16_t min[SENSOR_HISTORY_METRIC_COUNT] = {0};
+    int16_t max[SENSOR_HISTORY_METRIC_COUNT] = {0};
+    float mean[SENSOR_HISTORY_METRIC_COUNT] = {0};
+
+    /* Copy under the lock, decode outside it. */
+    portENTER_CRITICAL(&s_lock);
+    const history_acc_t* acc = tier->acc;
+    if (tier->slots != NULL && acc->open && age <= tier->len && (size_t)acc->index >= age) {
+        index = acc->index - (uint32_t)age;
+        if (age == 0U) {
+            count = acc->count;
+            iaq_count = acc->iaq_count;
+            memcpy(min, acc->min, sizeof(min));
+            memcpy(max, acc->max, sizeof(max));
+            for (int m = 0; m < SENSOR_HISTORY_METRIC_COUNT; m++) {
+                uint16_t n = history_metric_count((sensor_history_metric_t)m, count, iaq_count);
+                mean[m] = n ? (float)acc->sum[m] / (float)n : 0.0f;
+            }
+        } else {
+            const history_slot_t* slot = &tier->slots[index % tier->len];
+            if (slot->index == index) {
+                count = slot->count;
+                iaq_count = slot->iaq_count;
+                memcpy(min, slot->min, sizeof(min));
+                memcpy(max, slot->max, sizeof(max));
+                for (int m = 0; m < SENSOR_HISTORY_METRIC_COUNT; m++) {
+                    mean[m] = (float)slot->mean[m];
+                }
+            }
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (count == 0U) {
+        return false;
+    }
+
+    out_bucket->start_us = (int64_t)index * (int64_t)tier->bucket_s * 1000000LL;
+    for (int m = 0; m < SENSOR_HISTORY_METRIC_COUNT; m++) {
+        sensor_history_stat_t* stat = &out_bucket->metrics[m];
+        stat->count = history_metric_count((sensor_history_metric_t)m, count, iaq_count);
+        stat->min = stat->count ? history_decode((sensor_history_metric_t)m, (float)min[m]) : 0.0f;
+        stat->max = stat->count ? history_decode((sensor_history_metric_t)m, (float)max[m]) : 0.0f;
+        stat->mean = stat->count ? history_decode((sensor_history_metric_t)m, mean[m]) : 0.0f;
+    }
+    return true;
+}
+
+size_t sensor_history_get_capacity(sensor_history_tier_t tier)
+{
+    return ((unsigned int)tier < SENSOR_HISTORY_TIER_COUNT) ? s_tiers[tier].len : 0U;
+}
+
+uint32_t sensor_history_get_bucket_s(sensor_history_tier_t tier)
+{
+    return ((unsigned int)tier < SENSOR_HISTORY_TIER_COUNT) ? s_tiers[tier].bucket_s : 0U;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "nvs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Single owner of NVS: initializes the flash partition once, keeps one open
+ * handle per namespace and caches values in RAM. Changes made with the
+ * settings_set_*() calls are debounced: they are written together after
+ * CONFIG_SETTINGS_COMMIT_DELAY_MS without further changes, by a
+ * low-priority task, or on settings_flush().
+ */
+
+/**
+ * @brief Write counters since boot.
+ */
+typedef struct {
+    /**< settings_set_*() calls that changed a cached value. */
+    uint32_t changes;
+    /**< Keys written to NVS. */
+    uint32_t flash_writes;
+    /**< NVS commits. */
+    uint32_t commits;
+} settings_stats_t;
+
+/**
+ * @brief Initialize NVS and the settings cache.
+ *
+ * Erases and re-initializes the NVS partition when it is full or was written
+ * by a newer NVS version. Safe to call more than once; every other function
+ * calls it on first use.
+ *
+ * @return
+ * - ESP_OK: settings are ready.
+ * - ESP_ERR_NO_MEM: lock, commit task or timer could not be created.
+ * - Other error from nvs_flash_init().
+ */
+esp_err_t settings_init(void);
+
+/**
+ * @brief Get the cached read-write handle for a namespace.
+ *
+ * For callers that manage their own keys and commits (large state blobs).
+ * The handle stays open for the lifetime of the application; do not close it.
+ *
+ * @param[in] ns NVS namespace.
+ * @param[out] out_handle Output handle.
+ *
+ * @return ESP_OK or an error from settings_init() / nvs_open().
+ */
+esp_err_t settings_get_handle(const char* ns, nvs_handle_t* out_handle);
+
+/**
+ * @brief Read a u8 setting, from RAM when cached.
+ *
+ * @return
+ * - ESP_OK: @p out_value filled.
+ * - ESP_ERR_NVS_NOT_FOUND: no value stored.
+ * - ESP_ERR_INVALID_ARG: NULL argument.
+ * - Other error from NVS.
+ */
+esp_err_t settings_get_u8(const char* ns, const char* key, uint8_t* out_value);
+
+/**
+ * @brief Change a u8 setting; written to NVS after the debounce period.
+ *
+ * Setting the value already stored costs nothing.
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG for NULL arguments, or ESP_ERR_NO_MEM.
+ */
+esp_err_t settings_set_u8(const char* ns, const char* key, uint8_t value);
+
+/**
+ * @brief Read a fixed-size blob setting, from RAM when cached.
+ *
+ * @return
+ * - ESP_OK: @p out filled.
+ * - ESP_ERR_NVS_NOT_FOUND: no value stored.
+ * - ESP_ERR_INVALID_SIZE: the stored blob has a different size (e.g. an older record layout).
+ * - ESP_ERR_INVALID_ARG: NULL argument or zero size.
+ * - Other error from NVS.
+ */
+esp_err_t settings_get_blob(const char* ns, const char* key, void* out, size_t size);
+
+/**
+ * @brief Change a blob setting; written to NVS after the debounce period.
+ *
+ * The data is copied. Setting the content already stored costs nothing.
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG for NULL arguments or zero size, or ESP_ERR_NO_MEM.
+ */
+esp_err_t settings_set_blob(const char* ns, const char* key, const void* data, size_t size);
+
+/**
+ * @brief Write all pending changes now, one commit per namespace.
+ *
+ * Call at the end of an interaction (e.g. a settings screen closes) and
+ * before deep sleep or restart. Logs how many changes were coalesced.
+ *
+ * @return ESP_OK or the first NVS error; failed keys stay pending.
+ */
+esp_err_t settings_flush(void);
+
+/**
+ * @brief Get write counters since boot.
+ *
+ * @param[out] out_stats Output counters.
+ */
+void settings_get_stats(settings_stats_t* out_stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,442 @@
+#include "settings.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "nvs_flash.h"
+
+static const char* TAG = "settings";
+
+#define SETTINGS_TASK_STACK_SIZE 3072
+
+typedef enum {
+    SETTINGS_TYPE_U8 = 0,
+    SETTINGS_TYPE_BLOB,
+} settings_type_t;
+
+typedef struct {
+    char name[NVS_KEY_NAME_MAX_SIZE];
+    nvs_handle_t handle;
+} settings_ns_t;
+
+typedef struct {
+    bool used;
+    /**< Differs from NVS; written on the next flush. */
+    bool dirty;
+    settings_type_t type;
+    uint8_t ns_index;
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    /**< Value bytes: the u8 itself or a heap copy of the blob. */
+    uint8_t u8;
+    uint8_t* blob;
+    size_t size;
+} settings_entry_t;
+
+static bool s_initialized;
+static SemaphoreHandle_t s_lock;
+static esp_timer_handle_t s_commit_timer;
+/* Writes the debounced changes; the timer only wakes it, so NVS and flash never block the esp_timer task. */
+static TaskHandle_t s_commit_task;
+static settings_ns_t s_namespaces[CONFIG_SETTINGS_MAX_NAMESPACES];
+static size_t s_namespace_count;
+static settings_entry_t s_entries[CONFIG_SETTINGS_MAX_ENTRIES];
+static settings_stats_t s_stats;
+/* Changes since the last flush, for the coalescing log. */
+static uint32_t s_pending_changes;
+
+static void settings_commit_timer_cb(void* arg)
+{
+    (void)arg;
+    xTaskNotifyGive(s_commit_task);
+}
+
+static void settings_commit_task(void* arg)
+{
+    (void)arg;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        (void)settings_flush();
+    }
+}
+
+esp_err_t settings_init(void)
+{
+    if (s_initialized) {
+        return ESP_OK;
+    }
+
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_LOGW(TAG, "NVS requires erase, retrying");
+        ret = nvs_flash_erase();
+        if (ret == ESP_OK) {
+            ret = nvs_flash_init();
+        }
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "NVS init failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    s_lock = xSemaphoreCreateMutex();
+    if (!s_lock) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    const esp_timer_create_args_t args = {
+        .callback = settings_commit_timer_cb,
+        .name = "settings_commit",
+    };
+    if (xTaskCreate(settings_commit_task,
+            "settings",
+            SETTINGS_TASK_STACK_SIZE,
+            NULL,
+            CONFIG_SETTINGS_TASK_PRIORITY,
+            &s_commit_task) != pdPASS) {
+        vSemaphoreDelete(s_lock);
+        s_lock = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    ret = esp_timer_create(&args, &s_commit_timer);
+    if (ret != ESP_OK) {
+        vTaskDelete(s_commit_task);
+        s_commit_task = NULL;
+        vSemaphoreDelete(s_lock);
+        s_lock = NULL;
+        return ret;
+    }
+
+    s_initialized = true;
+    return ESP_OK;
+}
+
+/* Called with s_lock held. */
+static esp_err_t settings_ns_index(const char* ns, uint8_t* out_index)
+{
+    for (size_t i = 0; i < s_namespace_count; i++) {
+        if (strcmp(s_namespaces[i].name, ns) == 0) {
+            *out_index = (uint8_t)i;
+            return ESP_OK;
+        }
+    }
+
+    if (s_namespace_count >= CONFIG_SETTINGS_MAX_NAMESPACES || strlen(ns) >= NVS_KEY_NAME_MAX_SIZE) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    settings_ns_t* slot = &s_namespaces[s_namespace_count];
+    esp_err_t ret = nvs_open(ns, NVS_READWRITE, &slot->handle);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to open namespace %s: %s", ns, esp_err_to_name(ret));
+        return ret;
+    }
+    strcpy(slot->name, ns);
+    *out_index = (uint8_t)s_namespace_count;
+    s_namespace_count++;
+    return ESP_OK;
+}
+
+/* Called with s_lock held. */
+static settings_entry_t* settings_entry_find(uint8_t ns_index, const char* key)
+{
+    for (size_t i = 0; i < CONFIG_SETTINGS_MAX_ENTRIES; i++) {
+        settings_entry_t* e = &s_entries[i];
+        if (e->used && e->ns_index == ns_index && strcmp(e->key, key) == 0) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+/* Called with s_lock held. */
+static settings_entry_t* settings_entry_add(uint8_t ns_index, const char* key, settings_type_t type)
+{
+    if (strlen(key) >= NVS_KEY_NAME_MAX_SIZE) {
+        return NULL;
+    }
+
+    for (size_t i = 0; i < CONFIG_SETTINGS_MAX_ENTRIES; i++) {
+        settings_entry_t* e = &s_entries[i];
+        if (!e->used) {
+            memset(e, 0, sizeof(*e));
+            e->used = true;
+            e->type = type;
+            e->ns_index = ns_index;
+            strcpy(e->key, key);
+            return e;
+        }
+    }
+
+    ESP_LOGW(TAG, "Settings cache full, raise CONFIG_SETTINGS_MAX_ENTRIES");
+    return NULL;
+}
+
+/* Called with s_lock held. */
+static esp_err_t settings_entry_store_blob(settings_entry_t* e, const void* data, size_t size)
+{
+    if (e->size != size) {
+        uint8_t* blob = realloc(e->blob, size);
+        if (!blob) {
+            return ESP_ERR_NO_MEM;
+        }
+        e->blob = blob;
+        e->size = size;
+    }
+    memcpy(e->blob, data, size);
+    return ESP_OK;
+}
+
+static bool settings_lock(void)
+{
+    return settings_init() == ESP_OK && xSemaphoreTake(s_lock, portMAX_DELAY) == pdTRUE;
+}
+
+esp_err_t settings_get_handle(const char* ns, nvs_handle_t* out_handle)
+{
+    if (!ns || !out_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!settings_lock()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint8_t index = 0;
+    esp_err_t ret = settings_ns_index(ns, &index);
+    if (ret == ESP_OK) {
+        *out_handle = s_namespaces[index].handle;
+    }
+
+    xSemaphoreGive(s_lock);
+    return ret;
+}
+
+esp_err_t settings_get_u8(const char* ns, const char* key, uint8_t* out_value)
+{
+    if (!ns || !key || !out_value) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!settings_lock()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint8_t index = 0;
+    esp_err_t ret = settings_ns_index(ns, &index);
+    if (ret == ESP_OK) {
+        settings_entry_t* e = settings_entry_find(index, key);
+        if (e && e->type == SETTINGS_TYPE_U8) {
+            *out_value = e->u8;
+        } else {
+            ret = nvs_get_u8(s_namespaces[index].handle, key, out_value);
+            if (ret == ESP_OK && !e) {
+                e = settings_entry_add(index, key, SETTINGS_TYPE_U8);
+                if (e) {
+                    e->u8 = *out_value;
+                }
+            }
+        }
+    }
+
+    xSemaphoreGive(s_lock);
+    return ret;
+}
+
+esp_err_t settings_get_blob(const char* ns, const char* key, void* out, size_t size)
+{
+    if (!ns || !key || !out || size == 0U) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!settings_lock()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint8_t index = 0;
+    esp_err_t ret = settings_ns_index(ns, &index);
+    if (ret == ESP_OK) {
+        settings_entry_t* e = settings_entry_find(index, key);
+        if (e && e->type == SETTINGS_TYPE_BLOB) {
+            if (e->size == size) {
+                memcpy(out, e->blob, size);
+            } else {
+                ret = ESP_ERR_INVALID_SIZE;
+            }
+        } else {
+            size_t len = 0;
+            ret = nvs_get_blob(s_namespaces[index].handle, key, NULL, &len);
+            if (ret == ESP_OK && len != size) {
+                ret = ESP_ERR_INVALID_SIZE;
+            }
+            if (ret == ESP_OK) {
+                ret = nvs_get_blob(s_namespaces[index].handle, key, out, &len);
+            }
+            if (ret == ESP_OK && !e) {
+                e = settings_entry_add(index, key, SETTINGS_TYPE_BLOB);
+                if (e && settings_entry_store_blob(e, out, size) != ESP_OK) {
+                    e->used = false;
+                }
+            }
+        }
+    }
+
+    xSemaphoreGive(s_lock);
+    return ret;
+}
+
+/* Called with s_lock held, after a cached value changed. */
+static void settings_mark_dirty(settings_entry_t* e)
+{
+    e->dirty = true;
+    s_stats.changes++;
+    s_pending_changes++;
+
+    esp_timer_stop(s_commit_timer);
+    esp_timer_start_once(s_commit_timer, (uint64_t)CONFIG_SETTINGS_COMMIT_DELAY_MS * 1000ULL);
+}
+
+esp_err_t settings_set_u8(const char* ns, const char* key, uint8_t value)
+{
+    if (!ns || !key) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!settings_lock()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint8_t index = 0;
+    esp_err_t ret = settings_ns_index(ns, &index);
+    if (ret == ESP_OK) {
+        settings_entry_t* e = settings_entry_find(index, key);
+        if (!e) {
+            /* Not read since boot: compare against flash so an unchanged value is not rewritten. */
+            uint8_t stored = 0;
+            bool known = (nvs_get_u8(s_namespaces[index].handle, key, &stored) == ESP_OK);
+            e = settings_entry_add(index, key, SETTINGS_TYPE_U8);
+            if (e && known) {
+                e->u8 = stored;
+            } else if (e) {
+                e->u8 = (uint8_t)~value;
+            }
+        }
+
+        if (!e) {
+            ret = ESP_ERR_NO_MEM;
+        } else if (e->type != SETTINGS_TYPE_U8 || e->u8 != value) {
+            e->type = SETTINGS_TYPE_U8;
+            e->u8 = value;
+            settings_mark_dirty(e);
+        }
+    }
+
+    xSemaphoreGive(s_lock);
+    return ret;
+}
+
+esp_err_t settings_set_blob(const char* ns, const char* key, const void* data, size_t size)
+{
+    if (!ns || !key || !data || size == 0U) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!settings_lock()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint8_t index = 0;
+    esp_err_t ret = settings_ns_index(ns, &index);
+    if (ret == ESP_OK) {
+        settings_entry_t* e = settings_entry_find(index, key);
+        bool changed = true;
+        if (e) {
+            changed = (e->type != SETTINGS_TYPE_BLOB) || (e->size != size) || (memcmp(e->blob, data, size) != 0);
+        } else {
+            e = settings_entry_add(index, key, SETTINGS_TYPE_BLOB);
+        }
+
+        if (!e) {
+            ret = ESP_ERR_NO_MEM;
+        } else if (changed) {
+            e->type = SETTINGS_TYPE_BLOB;
+            ret = settings_entry_store_blob(e, data, size);
+            if (ret == ESP_OK) {
+                settings_mark_dirty(e);
+            } else if (e->size == 0U) {
+                e->used = false;
+            }
+        }
+    }
+
+    xSemaphoreGive(s_lock);
+    return ret;
+}
+
+esp_err_t settings_flush(void)
+{
+    if (!settings_lock()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_timer_stop(s_commit_timer);
+
+    esp_err_t first_err = ESP_OK;
+    uint32_t writes = 0;
+    uint32_t commits = 0;
+    for (size_t n = 0; n < s_namespace_count; n++) {
+        nvs_handle_t handle = s_namespaces[n].handle;
+        bool written = false;
+
+        for (size_t i = 0; i < CONFIG_SETTINGS_MAX_ENTRIES; i++) {
+            settings_entry_t* e = &s_entries[i];
+            if (!e->used || !e->dirty || e->ns_index != n) {
+                continue;
+            }
+
+            esp_err_t ret = (e->type == SETTINGS_TYPE_U8) ? nvs_set_u8(handle, e->key, e->u8)
+                                                          : nvs_set_blob(handle, e->key, e->blob, e->size);
+            if (ret == ESP_OK) {
+                e->dirty = false;
+                written = true;
+                writes++;
+            } else {
+                ESP_LOGW(TAG, "Failed to write %s/%s: %s", s_namespaces[n].name, e->key, esp_err_to_name(ret));
+                if (first_err == ESP_OK) {
+                    first_err = ret;
+                }
+            }
+        }
+
+        if (written) {
+            esp_err_t ret = nvs_commit(handle);
+            commits++;
+            if (ret != ESP_OK && first_err == ESP_OK) {
+                first_err = ret;
+            }
+        }
+    }
+
+    if (writes > 0U) {
+        ESP_LOGI(TAG,
+            "Flushed %lu change(s) as %lu key write(s), %lu commit(s)",
+            (unsigned long)s_pending_changes,
+            (unsigned long)writes,
+            (unsigned long)commits);
+    }
+    s_stats.flash_writes += writes;
+    s_stats.commits += commits;
+    s_pending_changes = 0;
+
+    xSemaphoreGive(s_lock);
+    return first_err;
+}
+
+void settings_get_stats(settings_stats_t* out_stats)
+{
+    if (!out_stats || !settings_lock()) {
+        return;
+    }
+
+    *out_stats = s_stats;
+    xSemaphoreGive(s_lock);
+}
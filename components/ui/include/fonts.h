@@ -11,6 +11,20 @@ extern const lv_font_t ui_font_sf_sb_50_digits;
 extern const lv_font_t ui_font_sf_sb_30_digits;
 extern const lv_font_t ui_font_sf_b_10_digits;
 
+/**
+ * @brief Measure average glyph fetch time of a font.
+ *
+ * Looks up and fetches the bitmap of every glyph in @p text, @p iterations
+ * times. For compressed fonts this includes the RLE decode done on every draw.
+ * Must be called with the LVGL lock held.
+ *
+ * @param[in] font Font to measure.
+ * @param[in] text UTF-8 glyphs to fetch.
+ * @param[in] iterations Number of passes over @p text.
+ * @return Average time per glyph in nanoseconds, from the microsecond esp_timer clock.
+ */
+uint32_t ui_font_measure_glyph_ns(const lv_font_t* font, const char* text, uint32_t iterations);
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
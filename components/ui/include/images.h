@@ -3,7 +3,7 @@
 #include <stdbool.h>
 #include <lvgl.h>
 
-#define IMG_PATH(name) "S:/spiffs/img_" name ".bin"
+#define IMG_PATH(name) "S:/assets/img_" name ".bin"
 
 #define IMG_BASE IMG_PATH("base")
 #define IMG_ULTRA_HAPPY IMG_PATH("ultra_happy")
@@ -24,6 +24,7 @@ enum ScreensEnum {
     SCREEN_ID_CHARGING,
     SCREEN_ID_BRIGHTNESS,
     SCREEN_ID_QUESTION,
+    SCREEN_ID_AMBIENT,
     SCREEN_COUNT_TOTAL
 };
 
@@ -82,6 +83,12 @@ typedef struct {
     lv_obj_t* btn_question_no;
     lv_obj_t* lbl_question_batt_pct;
     lv_obj_t* img_question_battery;
+
+    lv_obj_t* screen_ambient;
+    lv_obj_t* lbl_ambient_iaq_title;
+    lv_obj_t* lbl_ambient_iaq_value;
+    lv_obj_t* lbl_ambient_temp_title;
+    lv_obj_t* lbl_ambient_temp_value;
 } ui_objects_t;
 
 extern ui_objects_t ui_objects;
@@ -105,6 +112,8 @@ void create_screen_brightness(uint8_t value_percent);
 
 void create_screen_question(const char* text);
 
+void create_screen_ambient(void);
+
 void tick_screen_by_id(enum ScreensEnum screenId);
 void tick_screen(int screen_index);
 
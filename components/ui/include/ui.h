@@ -14,6 +14,16 @@ extern "C" {
  */
 void ui_init();
 
+/**
+ * @brief Initialize UI subsystem directly on a data screen, skipping the startup screen.
+ *
+ * Used to resume after deep sleep. Falls back to ui_init() behaviour when
+ * @p screenId is not a regular data screen.
+ *
+ * @param[in] screenId Data screen to show first.
+ */
+void ui_init_at(enum ScreensEnum screenId);
+
 /**
  * @brief Finalize startup transition and move to runtime screens.
  *
@@ -96,6 +106,20 @@ void loadScreen(enum ScreensEnum screenId);
  */
 enum ScreensEnum ui_get_current_screen(void);
 
+/**
+ * @brief Get the regular data screen shown last, also while a special screen is up.
+ *
+ * @return Data screen id (SCREEN_ID_IAQ before any was shown).
+ */
+enum ScreensEnum ui_get_data_screen(void);
+
+/**
+ * @brief Mark the shown sensor values as stale (dimmed) or fresh.
+ *
+ * @param[in] stale True while the values are from before the last deep sleep.
+ */
+void ui_set_values_stale(bool stale);
+
 /**
  * @brief Show startup screen.
  */
@@ -150,6 +174,13 @@ void ui_question_select_no(void);
  */
 void ui_question_confirm(void);
 
+/**
+ * @brief Show the ambient glance screen (IAQ and temperature only).
+ *
+ * Value updates redraw the ambient labels only when their text changes.
+ */
+void ui_show_ambient(void);
+
 /**
  * @brief Hide special screen and return to previous regular screen.
  */
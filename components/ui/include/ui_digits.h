@@ -0,0 +1,89 @@
+#pragma once
+
+#include <lvgl.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define UI_DIGITS_MAX_CELLS 6
+
+/**
+ * @brief Pre-blended glyph sprite placed inside a fixed-width cell.
+ */
+typedef struct {
+    uint32_t letter;  /*!< Unicode code point */
+    uint8_t cell_w;   /*!< Cell advance in pixels (equal for all digits) */
+    int8_t x;         /*!< Sprite offset from the cell left edge */
+    int8_t y;         /*!< Sprite offset from the line top */
+    lv_img_dsc_t img; /*!< RGB565 sprite, already blended onto the background */
+} ui_digit_sprite_t;
+
+/**
+ * @brief Set of sprites rasterized from one font (generated by tools/digit_atlas.py).
+ */
+typedef struct {
+    const ui_digit_sprite_t* sprites;
+    uint8_t sprite_count;
+    uint8_t cell_h; /*!< Line height of the source font */
+} ui_digit_atlas_t;
+
+extern const ui_digit_atlas_t ui_digit_atlas_sf_sb_60;
+extern const ui_digit_atlas_t ui_digit_atlas_sf_sb_50;
+
+/**
+ * @brief Create a digit display that blits atlas sprites instead of rendering text.
+ *
+ * The object draws an opaque black background and horizontally centers its
+ * cells. Sprites are blended for white on black, so other colors are ignored.
+ *
+ * @param[in] parent Parent object.
+ * @param[in] atlas Sprite atlas to draw with.
+ * @return Created object.
+ */
+lv_obj_t* ui_digits_create(lv_obj_t* parent, const ui_digit_atlas_t* atlas);
+
+/**
+ * @brief Set shown text and invalidate only the cells that changed.
+ *
+ * Characters missing from the atlas are skipped. If the cell layout changes
+ * (different length or symbol positions), the whole object is invalidated.
+ *
+ * @param[in] obj Digit display.
+ * @param[in] text UTF-8 text, at most UI_DIGITS_MAX_CELLS glyphs.
+ */
+void ui_digits_set_text(lv_obj_t* obj, const char* text);
+
+/**
+ * @brief Switch to another atlas and redraw the whole object.
+ *
+ * @param[in] obj Digit display.
+ * @param[in] atlas Sprite atlas to draw with.
+ */
+void ui_digits_set_atlas(lv_obj_t* obj, const ui_digit_atlas_t* atlas);
+
+/**
+ * @brief Measure redraw time of a big value, label versus digit display.
+ *
+ * Loads a temporary screen holding a 60 px value (an lv_label or a digit
+ * display), steps it through @p changes consecutive values with a synchronous
+ * refresh after each one and restores the previous screen. Must be called with
+ * the LVGL lock held after the display is registered.
+ *
+ * @param[in] use_atlas Measure the digit display instead of the label.
+ * @param[in] changes Number of value changes.
+ * @param[in] refresh Renders and flushes one frame synchronously, through the
+ *                    display driver's refresh path so its frame stats count it
+ *                    (e.g. display_lvgl_render_now()).
+ * @param[in] on_ready Optional hook called after the initial full refresh, right
+ *                     before the timed changes (e.g. to reset flush counters).
+ * @return Total time in microseconds.
+ */
+uint32_t ui_digits_measure_redraw_us(
+    bool use_atlas, uint32_t changes, uint32_t (*refresh)(void), void (*on_ready)(void));
+
+#ifdef __cplusplus
+}
+#endif
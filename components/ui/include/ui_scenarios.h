@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Outcome of one scripted UI scenario.
+ */
+typedef struct {
+    const char* name;    /*!< Scenario name */
+    uint32_t render_ms;  /*!< Render time reported by LVGL for the scenario's refreshes */
+    uint32_t frames;     /*!< Refreshes that rendered at least one area */
+    uint32_t dirty_px;   /*!< Pixels LVGL re-rendered */
+    uint32_t crc;        /*!< CRC32 of the resulting screen, 0 if the snapshot failed */
+    uint32_t golden_crc; /*!< Stored golden CRC, 0 if none is recorded */
+    const void* frame;   /*!< Snapshot pixels (LV_IMG_CF_TRUE_COLOR), only valid inside the callback; NULL if it failed */
+    uint32_t frame_size; /*!< Snapshot size in bytes */
+} ui_scenario_result_t;
+
+/**
+ * @brief Scenario result callback.
+ *
+ * @param[in] result Result of the scenario that just finished.
+ */
+typedef void (*ui_scenario_report_cb_t)(const ui_scenario_result_t* result);
+
+/**
+ * @brief Drive the UI through scripted scenarios and check the frames.
+ *
+ * Each scenario calls the public UI API (loadScreen, ui_update_*,
+ * ui_show_question, ...), refreshes synchronously while counting render time
+ * and dirty area through the display monitor callback, then snapshots the
+ * active screen and compares its CRC32 to the stored golden value. Golden
+ * values are recorded from frames checked by eye (test/host writes them out). UI values
+ * and the active screen are restored afterwards. Needs LV_USE_SNAPSHOT and the
+ * LVGL lock, after ui_init().
+ *
+ * @param[in] report_cb Called once per scenario, may be NULL.
+ * @return Number of failed scenarios: CRC differs from the golden value, no
+ *         golden value is recorded, or the snapshot failed.
+ */
+uint32_t ui_scenarios_run(ui_scenario_report_cb_t report_cb);
+
+#ifdef __cplusplus
+}
+#endif
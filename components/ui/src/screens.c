@@ -4,6 +4,7 @@
 #include "fonts.h"
 #include "images.h"
 #include "ui.h"
+#include "ui_internal.h"
 
 ui_objects_t ui_objects;
 
@@ -43,6 +44,25 @@ static void create_page_indicators(lv_obj_t* parent, int active_index)
     }
 }
 
+static lv_obj_t* create_value(lv_obj_t* parent, const lv_font_t* font, const char* text)
+{
+#if CONFIG_UI_DIGIT_ATLAS
+    lv_obj_t* obj = ui_digits_create(parent, ui_value_atlas(font));
+    lv_obj_set_pos(obj, 0, 72);
+    lv_obj_set_size(obj, 135, 49);
+    ui_digits_set_text(obj, text);
+#else
+    lv_obj_t* obj = lv_label_create(parent);
+    lv_obj_set_pos(obj, 0, 72);
+    lv_obj_set_size(obj, 135, 49);
+    lv_obj_set_style_text_color(obj, lv_color_hex(0xffffffff), LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_set_style_text_font(obj, font, LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_set_style_text_align(obj, LV_TEXT_ALIGN_CENTER, LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_label_set_text(obj, text);
+#endif
+    return obj;
+}
+
 void create_screen_iaq(void)
 {
     lv_obj_t* obj = lv_obj_create(0);
@@ -66,13 +86,7 @@ void create_screen_iaq(void)
     img_set(ui_objects.img_iaq_status, &IMG_INFO_GOOD);
 
     // Value Label
-    ui_objects.lbl_iaq_value = lv_label_create(obj);
-    lv_obj_set_pos(ui_objects.lbl_iaq_value, 0, 72);
-    lv_obj_set_size(ui_objects.lbl_iaq_value, 135, 49);
-    lv_obj_set_style_text_color(ui_objects.lbl_iaq_value, lv_color_hex(0xffffffff), LV_PART_MAIN | LV_STATE_DEFAULT);
-    lv_obj_set_style_text_font(ui_objects.lbl_iaq_value, &ui_font_sf_sb_60_digits, LV_PART_MAIN | LV_STATE_DEFAULT);
-    lv_obj_set_style_text_align(ui_objects.lbl_iaq_value, LV_TEXT_ALIGN_CENTER, LV_PART_MAIN | LV_STATE_DEFAULT);
-    lv_label_set_text(ui_objects.lbl_iaq_value, "000");
+    ui_objects.lbl_iaq_value = create_value(obj, &ui_font_sf_sb_60_digits, "000");
 
     ui_objects.lbl_iaq_warmup = lv_label_create(obj);
     lv_obj_set_pos(ui_objects.lbl_iaq_warmup, 0, 174);
@@ -117,13 +131,7 @@ void create_screen_temp(void)
     img_set(ui_objects.img_temp_status, &IMG_INFO_NOTHING);
 
     // Value Label
-    ui_objects.lbl_temp_value = lv_label_create(obj);
-    lv_obj_set_pos(ui_objects.lbl_temp_value, 0, 72);
-    lv_obj_set_size(ui_objects.lbl_temp_value, 135, 49);
-    lv_obj_set_style_text_color(ui_objects.lbl_temp_value, lv_color_hex(0xffffffff), LV_PART_MAIN | LV_STATE_DEFAULT);
-    lv_obj_set_style_text_font(ui_objects.lbl_temp_value, &ui_font_sf_sb_60_digits, LV_PART_MAIN | LV_STATE_DEFAULT);
-    lv_obj_set_style_text_align(ui_objects.lbl_temp_value, LV_TEXT_ALIGN_CENTER, LV_PART_MAIN | LV_STATE_DEFAULT);
-    lv_label_set_text(ui_objects.lbl_temp_value, "00°");
+    ui_objects.lbl_temp_value = create_value(obj, &ui_font_sf_sb_60_digits, "00°");
 
     // Icon Img
     ui_objects.img_temp_icon = lv_img_create(obj);
@@ -159,13 +167,7 @@ void create_screen_hum(void)
     img_set(ui_objects.img_hum_status, &IMG_INFO_HUM_DRY);
 
     // Value Label
-    ui_objects.lbl_hum_value = lv_label_create(obj);
-    lv_obj_set_pos(ui_objects.lbl_hum_value, 0, 72);
-    lv_obj_set_size(ui_objects.lbl_hum_value, 135, 49);
-    lv_obj_set_style_text_color(ui_objects.lbl_hum_value, lv_color_hex(0xffffffff), LV_PART_MAIN | LV_STATE_DEFAULT);
-    lv_obj_set_style_text_font(ui_objects.lbl_hum_value, &ui_font_sf_sb_50_digits, LV_PART_MAIN | LV_STATE_DEFAULT);
-    lv_obj_set_style_text_align(ui_objects.lbl_hum_value, LV_TEXT_ALIGN_CENTER, LV_PART_MAIN | LV_STATE_DEFAULT);
-    lv_label_set_text(ui_objects.lbl_hum_value, "00%");
+    ui_objects.lbl_hum_value = create_value(obj, &ui_font_sf_sb_50_digits, "00%");
 
     // Icon Img
     ui_objects.img_hum_icon = lv_img_create(obj);
@@ -347,3 +349,41 @@ void tick_screen_by_id(enum ScreensEnum screenId)
 {
     tick_screen_funcs[screenId - 1]();
 }
+
+static lv_obj_t* create_ambient_label(lv_obj_t* parent, int x, int y, int w, lv_color_t color, lv_text_align_t align)
+{
+    lv_obj_t* lbl = lv_label_create(parent);
+    lv_obj_set_pos(lbl, x, y);
+    lv_obj_set_size(lbl, w, LV_SIZE_CONTENT);
+    lv_obj_set_style_text_color(lbl, color, LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_set_style_text_font(lbl, &ui_font_sf_sb_30_digits, LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_set_style_text_align(lbl, align, LV_PART_MAIN | LV_STATE_DEFAULT);
+    return lbl;
+}
+
+void create_screen_ambient(void)
+{
+    lv_obj_t* obj = lv_obj_create(0);
+    ui_objects.screen_ambient = obj;
+    lv_obj_set_pos(obj, 0, 0);
+    lv_obj_set_size(obj, 135, 240);
+    lv_obj_set_style_bg_color(obj, lv_color_hex(0xff000000), LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_clear_flag(obj, LV_OBJ_FLAG_SCROLLABLE);
+
+    // Two rows in the middle band: title left, value right.
+    ui_objects.lbl_ambient_iaq_title =
+        create_ambient_label(obj, 8, 82, LV_SIZE_CONTENT, lv_color_hex(0xff808080), LV_TEXT_ALIGN_LEFT);
+    lv_label_set_text(ui_objects.lbl_ambient_iaq_title, "IAQ");
+
+    ui_objects.lbl_ambient_iaq_value =
+        create_ambient_label(obj, 62, 82, 65, lv_color_hex(0xffffffff), LV_TEXT_ALIGN_RIGHT);
+    lv_label_set_text(ui_objects.lbl_ambient_iaq_value, "");
+
+    ui_objects.lbl_ambient_temp_title =
+        create_ambient_label(obj, 8, 124, LV_SIZE_CONTENT, lv_color_hex(0xff808080), LV_TEXT_ALIGN_LEFT);
+    lv_label_set_text(ui_objects.lbl_ambient_temp_title, "Temp");
+
+    ui_objects.lbl_ambient_temp_value =
+        create_ambient_label(obj, 72, 124, 55, lv_color_hex(0xffffffff), LV_TEXT_ALIGN_RIGHT);
+    lv_label_set_text(ui_objects.lbl_ambient_temp_value, "");
+}
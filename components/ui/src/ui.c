@@ -10,11 +10,13 @@ int current_batt_pct = -1;
 bool current_batt_charging = false;
 bool current_stabilization_done = false;
 bool current_run_in_done = false;
+bool current_values_stale = false;
 uint8_t current_brightness_pct = 60;
 const uint8_t UI_BRIGHTNESS_MIN_PCT = 5;
 
 enum ScreensEnum currentScreenId = SCREEN_ID_NONE;
 enum ScreensEnum previousScreenId = SCREEN_ID_NONE;
+enum ScreensEnum lastDataScreenId = SCREEN_ID_IAQ;
 bool startup_non_critical_error = false;
 lv_obj_t* startup_error_icon = NULL;
 
@@ -44,6 +46,20 @@ void ui_init(void)
     ui_show_start();
 }
 
+void ui_init_at(enum ScreensEnum screenId)
+{
+    if (screenId >= SCREEN_ID_IAQ && screenId < SCREEN_ID_START) {
+        loadScreen(screenId);
+    } else {
+        ui_show_start();
+    }
+}
+
+enum ScreensEnum ui_get_data_screen(void)
+{
+    return lastDataScreenId;
+}
+
 void ui_finish_startup(bool has_non_critical_error)
 {
     startup_non_critical_error = has_non_critical_error;
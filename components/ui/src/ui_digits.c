@@ -0,0 +1,221 @@
+#include "ui_digits.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "esp_timer.h"
+#include "fonts.h"
+
+#define MY_CLASS &ui_digits_class
+
+typedef struct {
+    lv_obj_t obj;
+    const ui_digit_atlas_t* atlas;
+    const ui_digit_sprite_t* cells[UI_DIGITS_MAX_CELLS];
+    uint8_t cell_count;
+} ui_digits_t;
+
+static void ui_digits_event(const lv_obj_class_t* class_p, lv_event_t* e);
+
+static const lv_obj_class_t ui_digits_class = {
+    .event_cb = ui_digits_event,
+    .width_def = LV_PCT(100),
+    .height_def = LV_SIZE_CONTENT,
+    .instance_size = sizeof(ui_digits_t),
+    .base_class = &lv_obj_class,
+};
+
+static const ui_digit_sprite_t* ui_digits_find(const ui_digit_atlas_t* atlas, uint32_t letter)
+{
+    for (uint8_t i = 0; i < atlas->sprite_count; i++) {
+        if (atlas->sprites[i].letter == letter) {
+            return &atlas->sprites[i];
+        }
+    }
+    return NULL;
+}
+
+static lv_coord_t ui_digits_start_x(const lv_obj_t* obj, const ui_digit_sprite_t* const* cells, uint8_t count)
+{
+    lv_coord_t total_w = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        total_w += cells[i]->cell_w;
+    }
+    return obj->coords.x1 + (lv_obj_get_width(obj) - total_w) / 2;
+}
+
+static void ui_digits_sprite_area(const lv_obj_t* obj, const ui_digit_sprite_t* sprite, lv_coord_t cell_x, lv_area_t* area)
+{
+    area->x1 = cell_x + sprite->x;
+    area->y1 = obj->coords.y1 + sprite->y;
+    area->x2 = area->x1 + sprite->img.header.w - 1;
+    area->y2 = area->y1 + sprite->img.header.h - 1;
+}
+
+static void ui_digits_draw(lv_event_t* e)
+{
+    lv_obj_t* obj = lv_event_get_target(e);
+    ui_digits_t* digits = (ui_digits_t*)obj;
+    lv_draw_ctx_t* draw_ctx = lv_event_get_draw_ctx(e);
+
+    lv_draw_img_dsc_t img_dsc;
+    lv_draw_img_dsc_init(&img_dsc);
+    img_dsc.opa = lv_obj_get_style_img_opa(obj, LV_PART_MAIN);
+
+    lv_coord_t cell_x = ui_digits_start_x(obj, digits->cells, digits->cell_count);
+    for (uint8_t i = 0; i < digits->cell_count; i++) {
+        const ui_digit_sprite_t* sprite = digits->cells[i];
+        lv_area_t area;
+        lv_area_t clipped;
+        ui_digits_sprite_area(obj, sprite, cell_x, &area);
+        if (_lv_area_intersect(&clipped, &area, draw_ctx->clip_area)) {
+            lv_draw_img(draw_ctx, &img_dsc, &area, &sprite->img);
+        }
+        cell_x += sprite->cell_w;
+    }
+}
+
+static void ui_digits_event(const lv_obj_class_t* class_p, lv_event_t* e)
+{
+    (void)class_p;
+
+    /* The base class draws the opaque background and answers cover checks. */
+    if (lv_obj_event_base(MY_CLASS, e) != LV_RES_OK) {
+        return;
+    }
+
+    if (lv_event_get_code(e) == LV_EVENT_DRAW_MAIN) {
+        ui_digits_draw(e);
+    }
+}
+
+lv_obj_t* ui_digits_create(lv_obj_t* parent, const ui_digit_atlas_t* atlas)
+{
+    lv_obj_t* obj = lv_obj_class_create_obj(MY_CLASS, parent);
+    lv_obj_class_init_obj(obj);
+
+    ui_digits_t* digits = (ui_digits_t*)obj;
+    digits->atlas = atlas;
+    digits->cell_count = 0;
+
+    lv_obj_clear_flag(obj, LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_set_style_bg_color(obj, lv_color_hex(0xff000000), LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_set_style_bg_opa(obj, LV_OPA_COVER, LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_set_style_border_width(obj, 0, LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_set_style_radius(obj, 0, LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_set_style_pad_all(obj, 0, LV_PART_MAIN | LV_STATE_DEFAULT);
+    if (atlas) {
+        lv_obj_set_height(obj, atlas->cell_h);
+    }
+
+    return obj;
+}
+
+void ui_digits_set_text(lv_obj_t* obj, const char* text)
+{
+    ui_digits_t* digits = (ui_digits_t*)obj;
+    if (!obj || !text || !digits->atlas) {
+        return;
+    }
+
+    const ui_digit_sprite_t* cells[UI_DIGITS_MAX_CELLS];
+    uint8_t count = 0;
+    uint32_t ofs = 0;
+    while (text[ofs] != '\0' && count < UI_DIGITS_MAX_CELLS) {
+        const ui_digit_sprite_t* sprite = ui_digits_find(digits->atlas, _lv_txt_encoded_next(text, &ofs));
+        if (sprite) {
+            cells[count++] = sprite;
+        }
+    }
+
+    bool same_layout = (count == digits->cell_count);
+    for (uint8_t i = 0; same_layout && i < count; i++) {
+        same_layout = (cells[i]->cell_w == digits->cells[i]->cell_w);
+    }
+
+    if (!same_layout) {
+        memcpy(digits->cells, cells, sizeof(cells[0]) * count);
+        digits->cell_count = count;
+        lv_obj_invalidate(obj);
+        return;
+    }
+
+    /* Same cell positions: repaint only cells whose glyph changed. */
+    lv_coord_t cell_x = ui_digits_start_x(obj, cells, count);
+    for (uint8_t i = 0; i < count; i++) {
+        if (cells[i] != digits->cells[i]) {
+            lv_area_t old_area;
+            lv_area_t new_area;
+            ui_digits_sprite_area(obj, digits->cells[i], cell_x, &old_area);
+            ui_digits_sprite_area(obj, cells[i], cell_x, &new_area);
+            _lv_area_join(&new_area, &new_area, &old_area);
+            digits->cells[i] = cells[i];
+            lv_obj_invalidate_area(obj, &new_area);
+        }
+        cell_x += cells[i]->cell_w;
+    }
+}
+
+void ui_digits_set_atlas(lv_obj_t* obj, const ui_digit_atlas_t* atlas)
+{
+    ui_digits_t* digits = (ui_digits_t*)obj;
+    if (!obj || !atlas || digits->atlas == atlas) {
+        return;
+    }
+
+    /* Remap the current cells by letter into the new atlas. */
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < digits->cell_count; i++) {
+        const ui_digit_sprite_t* sprite = ui_digits_find(atlas, digits->cells[i]->letter);
+        if (sprite) {
+            digits->cells[count++] = sprite;
+        }
+    }
+    digits->cell_count = count;
+    digits->atlas = atlas;
+    lv_obj_invalidate(obj);
+}
+
+uint32_t ui_digits_measure_redraw_us(
+    bool use_atlas, uint32_t changes, uint32_t (*refresh)(void), void (*on_ready)(void))
+{
+    lv_obj_t* prev_screen = lv_scr_act();
+    lv_obj_t* screen = lv_obj_create(NULL);
+    lv_obj_set_style_bg_color(screen, lv_color_hex(0xff000000), LV_PART_MAIN | LV_STATE_DEFAULT);
+
+    lv_obj_t* value = NULL;
+    if (use_atlas) {
+        value = ui_digits_create(screen, &ui_digit_atlas_sf_sb_60);
+    } else {
+        value = lv_label_create(screen);
+        lv_obj_set_style_text_color(value, lv_color_hex(0xffffffff), LV_PART_MAIN | LV_STATE_DEFAULT);
+        lv_obj_set_style_text_font(value, &ui_font_sf_sb_60_digits, LV_PART_MAIN | LV_STATE_DEFAULT);
+        lv_obj_set_style_text_align(value, LV_TEXT_ALIGN_CENTER, LV_PART_MAIN | LV_STATE_DEFAULT);
+    }
+    lv_obj_set_pos(value, 0, 72);
+    lv_obj_set_size(value, 135, 49);
+
+    lv_scr_load(screen);
+    refresh();
+    if (on_ready) {
+        on_ready();
+    }
+
+    char buf[8];
+    int64_t start_us = esp_timer_get_time();
+    for (uint32_t i = 0; i < changes; i++) {
+        /* Slowly drifting reading: mostly the last digit changes. */
+        snprintf(buf, sizeof(buf), "%03u", (unsigned int)(100U + (i % 400U)));
+        if (use_atlas) {
+            ui_digits_set_text(value, buf);
+        } else {
+            lv_label_set_text(value, buf);
+        }
+        refresh();
+    }
+    uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - start_us);
+
+    lv_scr_load(prev_screen);
+    lv_obj_del(screen);
+
+    return elapsed_us;
+}
@@ -0,0 +1,34 @@
+#include "fonts.h"
+
+#include "esp_timer.h"
+
+uint32_t ui_font_measure_glyph_ns(const lv_font_t* font, const char* text, uint32_t iterations)
+{
+    if (!font || !text || iterations == 0U) {
+        return 0;
+    }
+
+    uint32_t glyphs_per_pass = 0;
+    int64_t start_us = esp_timer_get_time();
+
+    for (uint32_t i = 0; i < iterations; i++) {
+        uint32_t ofs = 0;
+        glyphs_per_pass = 0;
+        while (text[ofs] != '\0') {
+            uint32_t letter = _lv_txt_encoded_next(text, &ofs);
+            lv_font_glyph_dsc_t dsc;
+            if (!lv_font_get_glyph_dsc(font, &dsc, letter, 0)) {
+                continue;
+            }
+            /* Compressed fonts decode the whole glyph on every fetch. */
+            (void)lv_font_get_glyph_bitmap(font, letter);
+            glyphs_per_pass++;
+        }
+    }
+
+    int64_t elapsed_us = esp_timer_get_time() - start_us;
+    if (glyphs_per_pass == 0U) {
+        return 0;
+    }
+    return (uint32_t)(((uint64_t)elapsed_us * 1000ULL) / ((uint64_t)iterations * glyphs_per_pass));
+}
@@ -3,7 +3,14 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
 #include "ui.h"
+#if CONFIG_UI_DIGIT_ATLAS
+#include "ui_digits.h"
+#endif
 
 extern int current_iaq;
 extern uint8_t current_iaq_accuracy;
@@ -13,11 +20,13 @@ extern int current_batt_pct;
 extern bool current_batt_charging;
 extern bool current_stabilization_done;
 extern bool current_run_in_done;
+extern bool current_values_stale;
 extern uint8_t current_brightness_pct;
 extern const uint8_t UI_BRIGHTNESS_MIN_PCT;
 
 extern enum ScreensEnum currentScreenId;
 extern enum ScreensEnum previousScreenId;
+extern enum ScreensEnum lastDataScreenId;
 extern bool startup_non_critical_error;
 extern lv_obj_t* startup_error_icon;
 
@@ -28,3 +37,10 @@ extern bool question_selected_yes;
 void ui_apply_current_values(void);
 void ui_apply_brightness_value(void);
 void ui_apply_current_battery_status(void);
+
+/* Big value widgets are lv_label objects, or ui_digits with CONFIG_UI_DIGIT_ATLAS. */
+void ui_value_set_text(lv_obj_t* obj, const char* text);
+void ui_value_set_font(lv_obj_t* obj, const lv_font_t* font);
+#if CONFIG_UI_DIGIT_ATLAS
+const ui_digit_atlas_t* ui_value_atlas(const lv_font_t* font);
+#endif
@@ -86,5 +86,8 @@ void loadScreen(enum ScreensEnum screenId)
     }
 
     currentScreenId = screenId;
+    if (newScreen) {
+        lastDataScreenId = screenId;
+    }
     ui_apply_current_values();
 }
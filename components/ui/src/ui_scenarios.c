@@ -0,0 +1,188 @@
+#include "ui_scenarios.h"
+
+#include "ui_internal.h"
+
+typedef struct {
+    const char* name;
+    void (*run)(void);
+    uint32_t golden_crc; /* 0 until recorded from a checked frame; counts as a failure */
+} ui_scenario_t;
+
+typedef struct {
+    uint32_t render_ms;
+    uint32_t frames;
+    uint32_t dirty_px;
+} ui_scenario_monitor_t;
+
+static ui_scenario_monitor_t s_monitor;
+
+static void scenario_iaq(void)
+{
+    ui_update_battery(80, false);
+    ui_update_iaq_quality(3, true, true);
+    ui_update_iaq(42);
+    loadScreen(SCREEN_ID_IAQ);
+}
+
+static void scenario_iaq_step(void)
+{
+    ui_update_iaq(43);
+}
+
+static void scenario_iaq_warmup(void)
+{
+    ui_update_iaq_quality(0, false, false);
+}
+
+static void scenario_temp(void)
+{
+    ui_update_temp(23);
+    loadScreen(SCREEN_ID_TEMP);
+}
+
+static void scenario_temp_negative(void)
+{
+    ui_update_temp(-5);
+}
+
+static void scenario_hum(void)
+{
+    ui_update_hum(45);
+    loadScreen(SCREEN_ID_HUM);
+}
+
+static void scenario_hum_full(void)
+{
+    ui_update_hum(100);
+}
+
+static void scenario_battery_charging(void)
+{
+    ui_update_battery(15, true);
+}
+
+static void scenario_question(void)
+{
+    ui_show_question("Turn off?", NULL, NULL, true);
+}
+
+static void scenario_question_no(void)
+{
+    ui_question_select_no();
+}
+
+static void scenario_question_hide(void)
+{
+    ui_hide_special();
+}
+
+/* Golden CRCs depend on fonts, images and colors. Record them with the host
+ * build (test/host, --record) after checking the written frames by eye. */
+static const ui_scenario_t scenarios[] = {
+    {"iaq", scenario_iaq, 0},
+    {"iaq_step", scenario_iaq_step, 0},
+    {"iaq_warmup", scenario_iaq_warmup, 0},
+    {"temp", scenario_temp, 0},
+    {"temp_negative", scenario_temp_negative, 0},
+    {"hum", scenario_hum, 0},
+    {"hum_full", scenario_hum_full, 0},
+    {"battery_charging", scenario_battery_charging, 0},
+    {"question", scenario_question, 0},
+    {"question_no", scenario_question_no, 0},
+    {"question_hide", scenario_question_hide, 0},
+};
+
+static void ui_scenarios_monitor_cb(lv_disp_drv_t* drv, uint32_t time_ms, uint32_t px)
+{
+    (void)drv;
+    if (px == 0U) {
+        return;
+    }
+    s_monitor.render_ms += time_ms;
+    s_monitor.frames++;
+    s_monitor.dirty_px += px;
+}
+
+static uint32_t ui_scenarios_crc32(const uint8_t* data, uint32_t len)
+{
+    uint32_t crc = 0xFFFFFFFFU;
+    for (uint32_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1U)));
+        }
+    }
+    return ~crc;
+}
+
+uint32_t ui_scenarios_run(ui_scenario_report_cb_t report_cb)
+{
+    lv_disp_t* disp = lv_disp_get_default();
+    if (!disp) {
+        return 0;
+    }
+
+    /* Everything the scenarios touch, restored at the end. */
+    const enum ScreensEnum saved_screen = currentScreenId;
+    const enum ScreensEnum saved_previous_screen = previousScreenId;
+    const int saved_iaq = current_iaq;
+    const uint8_t saved_iaq_accuracy = current_iaq_accuracy;
+    const int saved_temp = current_temp;
+    const int saved_hum = current_hum;
+    const int saved_batt_pct = current_batt_pct;
+    const bool saved_batt_charging = current_batt_charging;
+    const bool saved_stabilization_done = current_stabilization_done;
+    const bool saved_run_in_done = current_run_in_done;
+
+    void (*saved_monitor_cb)(lv_disp_drv_t*, uint32_t, uint32_t) = disp->driver->monitor_cb;
+    disp->driver->monitor_cb = ui_scenarios_monitor_cb;
+
+    /* Start from a settled frame so the first scenario is not charged for it. */
+    lv_refr_now(disp);
+
+    uint32_t mismatches = 0;
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        s_monitor = (ui_scenario_monitor_t){0};
+
+        scenarios[i].run();
+        lv_refr_now(disp);
+
+        lv_img_dsc_t* snapshot = lv_snapshot_take(lv_scr_act(), LV_IMG_CF_TRUE_COLOR);
+        ui_scenario_result_t result = {
+            .name = scenarios[i].name,
+            .render_ms = s_monitor.render_ms,
+            .frames = s_monitor.frames,
+            .dirty_px = s_monitor.dirty_px,
+            .crc = snapshot ? ui_scenarios_crc32(snapshot->data, snapshot->data_size) : 0U,
+            .golden_crc = scenarios[i].golden_crc,
+            .frame = snapshot ? snapshot->data : NULL,
+            .frame_size = snapshot ? snapshot->data_size : 0U,
+        };
+        if (!snapshot || result.golden_crc == 0U || result.crc != result.golden_crc) {
+            mismatches++;
+        }
+        if (report_cb) {
+            report_cb(&result);
+        }
+        if (snapshot) {
+            lv_snapshot_free(snapshot);
+        }
+    }
+
+    disp->driver->monitor_cb = saved_monitor_cb;
+
+    current_iaq = saved_iaq;
+    current_temp = saved_temp;
+    current_hum = saved_hum;
+    ui_update_iaq_quality(saved_iaq_accuracy, saved_stabilization_done, saved_run_in_done);
+    ui_update_battery(saved_batt_pct, saved_batt_charging);
+    if (saved_screen == SCREEN_ID_START) {
+        ui_show_start();
+    } else if (saved_screen != SCREEN_ID_NONE && saved_screen != currentScreenId) {
+        loadScreen(saved_screen);
+    }
+    previousScreenId = saved_previous_screen;
+    ui_apply_current_values();
+
+    return mismatches;
+}
@@ -138,12 +138,27 @@ void ui_question_confirm(void)
     }
 }
 
+void ui_show_ambient(void)
+{
+    previousScreenId = currentScreenId;
+
+    lv_obj_t* oldScreen = lv_scr_act();
+    create_screen_ambient();
+
+    lv_scr_load(ui_objects.screen_ambient);
+    if (oldScreen) {
+        lv_obj_del(oldScreen);
+    }
+    currentScreenId = SCREEN_ID_AMBIENT;
+    ui_apply_current_values();
+}
+
 void ui_hide_special(void)
 {
     if (previousScreenId != SCREEN_ID_NONE && previousScreenId != SCREEN_ID_START &&
         previousScreenId != SCREEN_ID_CHARGING && previousScreenId != SCREEN_ID_NO_CHARGING &&
-        previousScreenId != SCREEN_ID_BRIGHTNESS &&
-        previousScreenId != SCREEN_ID_QUESTION) {
+        previousScreenId != SCREEN_ID_BRIGHTNESS && previousScreenId != SCREEN_ID_QUESTION &&
+        previousScreenId != SCREEN_ID_AMBIENT) {
         loadScreen(previousScreenId);
     } else {
         loadScreen(SCREEN_ID_IAQ);
@@ -1,11 +1,70 @@
 #include "ui_internal.h"
 
 #include <stdio.h>
+#include <string.h>
 
 #include "fonts.h"
 #include "images.h"
 #include "screens.h"
 
+#if CONFIG_UI_DIGIT_ATLAS
+const ui_digit_atlas_t* ui_value_atlas(const lv_font_t* font)
+{
+    return (font == &ui_font_sf_sb_50_digits) ? &ui_digit_atlas_sf_sb_50 : &ui_digit_atlas_sf_sb_60;
+}
+#endif
+
+void ui_value_set_text(lv_obj_t* obj, const char* text)
+{
+#if CONFIG_UI_DIGIT_ATLAS
+    ui_digits_set_text(obj, text);
+#else
+    lv_label_set_text(obj, text);
+#endif
+}
+
+void ui_value_set_font(lv_obj_t* obj, const lv_font_t* font)
+{
+#if CONFIG_UI_DIGIT_ATLAS
+    ui_digits_set_atlas(obj, ui_value_atlas(font));
+#else
+    lv_obj_set_style_text_font(obj, font, LV_PART_MAIN | LV_STATE_DEFAULT);
+#endif
+}
+
+/* Over the black background, a half-transparent value reads as dimmed without extra styles. */
+static void ui_value_set_stale(lv_obj_t* obj, bool stale)
+{
+    lv_opa_t opa = stale ? LV_OPA_50 : LV_OPA_COVER;
+#if CONFIG_UI_DIGIT_ATLAS
+    lv_obj_set_style_img_opa(obj, opa, LV_PART_MAIN | LV_STATE_DEFAULT);
+#else
+    lv_obj_set_style_text_opa(obj, opa, LV_PART_MAIN | LV_STATE_DEFAULT);
+#endif
+}
+
+static void ui_apply_stale_style(void)
+{
+    lv_obj_t* obj = NULL;
+    switch (currentScreenId) {
+        case SCREEN_ID_IAQ:
+            obj = ui_objects.lbl_iaq_value;
+            break;
+        case SCREEN_ID_TEMP:
+            obj = ui_objects.lbl_temp_value;
+            break;
+        case SCREEN_ID_HUM:
+            obj = ui_objects.lbl_hum_value;
+            break;
+        default:
+            break;
+    }
+
+    if (obj) {
+        ui_value_set_stale(obj, current_values_stale);
+    }
+}
+
 void ui_apply_brightness_value(void)
 {
     char buf[8];
@@ -53,7 +112,7 @@ static void ui_apply_iaq_screen_state(void)
 
     if (ui_objects.lbl_iaq_value) {
         snprintf(buf, sizeof(buf), "%03d", current_iaq);
-        lv_label_set_text(ui_objects.lbl_iaq_value, buf);
+        ui_value_set_text(ui_objects.lbl_iaq_value, buf);
         lv_obj_clear_flag(ui_objects.lbl_iaq_value, LV_OBJ_FLAG_HIDDEN);
     }
     if (ui_objects.img_iaq_icon) {
@@ -68,6 +127,29 @@ static void ui_apply_iaq_screen_state(void)
     }
 }
 
+static void ui_set_label_if_changed(lv_obj_t* lbl, const char* text)
+{
+    if (lbl && strcmp(lv_label_get_text(lbl), text) != 0) {
+        lv_label_set_text(lbl, text);
+    }
+}
+
+static void ui_apply_ambient_values(void)
+{
+    char buf[8];
+
+    /* No IAQ number until BSEC has a first estimate, same as the IAQ screen. */
+    if (current_iaq_accuracy == 0U) {
+        buf[0] = '\0';
+    } else {
+        snprintf(buf, sizeof(buf), "%d", current_iaq);
+    }
+    ui_set_label_if_changed(ui_objects.lbl_ambient_iaq_value, buf);
+
+    snprintf(buf, sizeof(buf), "%d", current_temp);
+    ui_set_label_if_changed(ui_objects.lbl_ambient_temp_value, buf);
+}
+
 static bool ui_battery_is_known(void)
 {
     return current_batt_pct >= 0;
@@ -150,7 +232,7 @@ void ui_apply_current_values(void)
         case SCREEN_ID_TEMP:
             if (ui_objects.lbl_temp_value) {
                 snprintf(buf, sizeof(buf), "%d°", current_temp);
-                lv_label_set_text(ui_objects.lbl_temp_value, buf);
+                ui_value_set_text(ui_objects.lbl_temp_value, buf);
             }
             if (ui_objects.img_temp_icon) {
                 img_set_info(ui_objects.img_temp_icon, get_temp_info(current_temp));
@@ -163,10 +245,10 @@ void ui_apply_current_values(void)
         case SCREEN_ID_HUM:
             if (ui_objects.lbl_hum_value) {
                 snprintf(buf, sizeof(buf), "%d%%", current_hum);
-                lv_label_set_text(ui_objects.lbl_hum_value, buf);
+                ui_value_set_text(ui_objects.lbl_hum_value, buf);
 
                 const lv_font_t* font = (current_hum == 100) ? &ui_font_sf_sb_50_digits : &ui_font_sf_sb_60_digits;
-                lv_obj_set_style_text_font(ui_objects.lbl_hum_value, font, LV_PART_MAIN | LV_STATE_DEFAULT);
+                ui_value_set_font(ui_objects.lbl_hum_value, font);
             }
             if (ui_objects.img_hum_icon) {
                 img_set_info(ui_objects.img_hum_icon, get_hum_info(current_hum));
@@ -180,20 +262,37 @@ void ui_apply_current_values(void)
             ui_apply_brightness_value();
             break;
 
+        case SCREEN_ID_AMBIENT:
+            ui_apply_ambient_values();
+            break;
+
         case SCREEN_ID_QUESTION:
         default:
             break;
     }
 
+    ui_apply_stale_style();
     ui_apply_current_battery_status();
 }
 
+void ui_set_values_stale(bool stale)
+{
+    if (current_values_stale == stale) {
+        return;
+    }
+
+    current_values_stale = stale;
+    ui_apply_stale_style();
+}
+
 void ui_update_iaq(int value)
 {
     current_iaq = value;
 
     if (currentScreenId == SCREEN_ID_IAQ) {
         ui_apply_iaq_screen_state();
+    } else if (currentScreenId == SCREEN_ID_AMBIENT) {
+        ui_apply_ambient_values();
     }
 }
 
@@ -201,11 +300,13 @@ void ui_update_temp(int value)
 {
     current_temp = value;
 
-    if (currentScreenId == SCREEN_ID_TEMP) {
+    if (currentScreenId == SCREEN_ID_AMBIENT) {
+        ui_apply_ambient_values();
+    } else if (currentScreenId == SCREEN_ID_TEMP) {
         char buf[8];
         if (ui_objects.lbl_temp_value) {
             snprintf(buf, sizeof(buf), "%d°", value);
-            lv_label_set_text(ui_objects.lbl_temp_value, buf);
+            ui_value_set_text(ui_objects.lbl_temp_value, buf);
         }
         if (ui_objects.img_temp_icon) {
             img_set_info(ui_objects.img_temp_icon, get_temp_info(value));
@@ -224,10 +325,10 @@ void ui_update_hum(int value)
         char buf[8];
         if (ui_objects.lbl_hum_value) {
             snprintf(buf, sizeof(buf), "%d%%", value);
-            lv_label_set_text(ui_objects.lbl_hum_value, buf);
+            ui_value_set_text(ui_objects.lbl_hum_value, buf);
 
             const lv_font_t* font = (value == 100) ? &ui_font_sf_sb_50_digits : &ui_font_sf_sb_60_digits;
-            lv_obj_set_style_text_font(ui_objects.lbl_hum_value, font, LV_PART_MAIN | LV_STATE_DEFAULT);
+            ui_value_set_font(ui_objects.lbl_hum_value, font);
         }
         if (ui_objects.img_hum_icon) {
             img_set_info(ui_objects.img_hum_icon, get_hum_info(value));
@@ -257,6 +358,9 @@ void ui_update_iaq_quality(uint8_t iaq_accuracy, bool stabilization_done, bool r
     if (currentScreenId == SCREEN_ID_IAQ) {
         ui_apply_iaq_screen_state();
     }
+    if (currentScreenId == SCREEN_ID_AMBIENT) {
+        ui_apply_ambient_values();
+    }
 }
 
 void ui_update_battery(int percent, bool charging)
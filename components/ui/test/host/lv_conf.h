@@ -0,0 +1,21 @@
+/*
+ * LVGL configuration of the host scenario build. Mirrors the options the
+ * device sets through sdkconfig.defaults and the ui Kconfig; everything else
+ * keeps the LVGL default, as it does on the device. Frames only match the
+ * device when these stay in sync.
+ */
+#pragma once
+
+#define LV_COLOR_DEPTH 16
+#define LV_COLOR_16_SWAP 1
+
+#define LV_MEM_CUSTOM 1
+#define LV_MEMCPY_MEMSET_STD 1
+#define LV_USE_USER_DATA 1
+#define LV_USE_FONT_COMPRESSED 1
+#define LV_USE_SNAPSHOT 1
+
+/* The device reads images through LV_USE_FS_STDIO on letter 'S'; the host
+ * registers its own driver on that letter to serve assets/. */
+#define LV_USE_FS_STDIO 0
+#define LV_IMG_CACHE_DEF_SIZE 0
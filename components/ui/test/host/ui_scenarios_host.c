@@ -0,0 +1,173 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lvgl.h"
+#include "ui.h"
+#include "ui_scenarios.h"
+
+/* Panel size as registered on the device (display.h WIDTH x HEIGHT). */
+#define HOST_HOR_RES 135
+#define HOST_VER_RES 240
+
+/* Device mount point in the image paths ("S:/assets/img_*.bin"). */
+#define HOST_ASSETS_PREFIX "/assets/"
+
+static lv_color_t s_draw_buf_pixels[HOST_HOR_RES * HOST_VER_RES];
+static lv_color_t s_framebuffer[HOST_HOR_RES * HOST_VER_RES];
+static const char* s_record_dir;
+static uint32_t s_failed;
+
+static void host_flush_cb(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_p)
+{
+    lv_coord_t w = lv_area_get_width(area);
+    for (lv_coord_t y = area->y1; y <= area->y2; y++) {
+        memcpy(&s_framebuffer[y * HOST_HOR_RES + area->x1], color_p, (size_t)w * sizeof(lv_color_t));
+        color_p += w;
+    }
+    lv_disp_flush_ready(drv);
+}
+
+static void* host_fs_open(lv_fs_drv_t* drv, const char* path, lv_fs_mode_t mode)
+{
+    (void)drv;
+    if (mode != LV_FS_MODE_RD || strncmp(path, HOST_ASSETS_PREFIX, strlen(HOST_ASSETS_PREFIX)) != 0) {
+        return NULL;
+    }
+
+    char full[512];
+    snprintf(full, sizeof(full), "%s/%s", UI_HOST_ASSETS_DIR, path + strlen(HOST_ASSETS_PREFIX));
+    return fopen(full, "rb");
+}
+
+static lv_fs_res_t host_fs_close(lv_fs_drv_t* drv, void* file)
+{
+    (void)drv;
+    fclose((FILE*)file);
+    return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t host_fs_read(lv_fs_drv_t* drv, void* file, void* buf, uint32_t btr, uint32_t* br)
+{
+    (void)drv;
+    *br = (uint32_t)fread(buf, 1, btr, (FILE*)file);
+    return ferror((FILE*)file) ? LV_FS_RES_FS_ERR : LV_FS_RES_OK;
+}
+
+static lv_fs_res_t host_fs_seek(lv_fs_drv_t* drv, void* file, uint32_t pos, lv_fs_whence_t whence)
+{
+    (void)drv;
+    int origin = (whence == LV_FS_SEEK_END) ? SEEK_END : ((whence == LV_FS_SEEK_CUR) ? SEEK_CUR : SEEK_SET);
+    return fseek((FILE*)file, (long)pos, origin) == 0 ? LV_FS_RES_OK : LV_FS_RES_FS_ERR;
+}
+
+static lv_fs_res_t host_fs_tell(lv_fs_drv_t* drv, void* file, uint32_t* pos)
+{
+    (void)drv;
+    long p = ftell((FILE*)file);
+    if (p < 0) {
+        return LV_FS_RES_FS_ERR;
+    }
+    *pos = (uint32_t)p;
+    return LV_FS_RES_OK;
+}
+
+static void host_register_fs(void)
+{
+    static lv_fs_drv_t drv;
+    lv_fs_drv_init(&drv);
+    drv.letter = 'S';
+    drv.open_cb = host_fs_open;
+    drv.close_cb = host_fs_close;
+    drv.read_cb = host_fs_read;
+    drv.seek_cb = host_fs_seek;
+    drv.tell_cb = host_fs_tell;
+    lv_fs_drv_register(&drv);
+}
+
+static void host_register_display(void)
+{
+    static lv_disp_draw_buf_t draw_buf;
+    static lv_disp_drv_t drv;
+    lv_disp_draw_buf_init(&draw_buf, s_draw_buf_pixels, NULL, HOST_HOR_RES * HOST_VER_RES);
+    lv_disp_drv_init(&drv);
+    drv.hor_res = HOST_HOR_RES;
+    drv.ver_res = HOST_VER_RES;
+    drv.draw_buf = &draw_buf;
+    drv.flush_cb = host_flush_cb;
+    lv_disp_drv_register(&drv);
+}
+
+/* Binary PPM, for checking a frame by eye before recording its CRC. */
+static void host_write_frame(const ui_scenario_result_t* result)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s.ppm", s_record_dir, result->name);
+    FILE* f = fopen(path, "wb");
+    if (!f) {
+        fprintf(stderr, "cannot write %s\n", path);
+        return;
+    }
+
+    const lv_color_t* px = (const lv_color_t*)result->frame;
+    uint32_t count = result->frame_size / sizeof(lv_color_t);
+    fprintf(f, "P6\n%d %d\n255\n", HOST_HOR_RES, HOST_VER_RES);
+    for (uint32_t i = 0; i < count; i++) {
+        lv_color32_t c = {.full = lv_color_to32(px[i])};
+        uint8_t rgb[3] = {c.ch.red, c.ch.green, c.ch.blue};
+        fwrite(rgb, 1, sizeof(rgb), f);
+    }
+    fclose(f);
+}
+
+static void host_report(const ui_scenario_result_t* result)
+{
+    const char* verdict = "ok";
+    if (result->frame == NULL) {
+        verdict = "NO SNAPSHOT";
+    } else if (result->golden_crc == 0U) {
+        verdict = "NO GOLDEN";
+    } else if (result->crc != result->golden_crc) {
+        verdict = "MISMATCH";
+    }
+    if (strcmp(verdict, "ok") != 0) {
+        s_failed++;
+    }
+
+    printf("scenario %-18s frames=%u dirty=%7u px crc=0x%08X golden=0x%08X %s\n",
+        result->name,
+        (unsigned int)result->frames,
+        (unsigned int)result->dirty_px,
+        (unsigned int)result->crc,
+        (unsigned int)result->golden_crc,
+        verdict);
+
+    if (s_record_dir && result->frame) {
+        host_write_frame(result);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc == 3 && strcmp(argv[1], "--record") == 0) {
+        s_record_dir = argv[2];
+    } else if (argc != 1) {
+        fprintf(stderr, "usage: %s [--record <dir>]\n", argv[0]);
+        return 2;
+    }
+
+    lv_init();
+    host_register_display();
+    host_register_fs();
+    ui_init();
+
+    uint32_t failed = ui_scenarios_run(host_report);
+    printf("%u scenario(s) failed\n", (unsigned int)failed);
+
+    if (s_record_dir) {
+        printf("frames written to %s; CRCs above go into scenarios[] in src/ui_scenarios.c once checked\n",
+            s_record_dir);
+        return 0;
+    }
+    return (failed > 0U || s_failed > 0U) ? 1 : 0;
+}
@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+"""Pre-rasterize font glyphs into an RGB565 sprite atlas for the ui_digits widget.
+
+Reads lv_font_conv generated fonts (see font_subset.py for the accepted
+format), blends every requested glyph between fixed foreground and background
+colors and writes one C file with a ui_digit_atlas_t per font. Digits share
+one tabular cell width so a value change never moves the other cells.
+"""
+
+import argparse
+import os
+import sys
+
+sys.dont_write_bytecode = True  # the build runs this from the source tree
+
+from font_subset import fail, glyph_id_for, parse_font, parse_glyph_list, unpack_pixels
+
+DIGITS = range(0x30, 0x3A)
+
+
+def rgb565(rgb, swap):
+    r = (rgb >> 16) & 0xFF
+    g = (rgb >> 8) & 0xFF
+    b = rgb & 0xFF
+    value = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3)
+    hi, lo = value >> 8, value & 0xFF
+    return (hi, lo) if swap else (lo, hi)
+
+
+def blend(fg, bg, alpha):
+    out = 0
+    for shift in (16, 8, 0):
+        f = (fg >> shift) & 0xFF
+        b = (bg >> shift) & 0xFF
+        out |= ((b * (255 - alpha) + f * alpha + 127) // 255) << shift
+    return out
+
+
+def adv_px(adv_w):
+    # Same rounding as lv_font_get_glyph_width() for fmt_txt fonts.
+    return (adv_w + 8) >> 4
+
+
+def build_sprites(font, codes, fg, bg, swap):
+    alpha_max = (1 << font["bpp"]) - 1
+    top = font["line_height"] - font["base_line"]
+
+    glyphs = []
+    for code in codes:
+        gid = glyph_id_for(font, code)
+        if gid is None:
+            fail("%s: U+%04X is not in the source font" % (font["name"], code))
+        glyphs.append((code, font["glyphs"][gid]))
+
+    digit_cell_w = 0
+    for code, (_, adv_w, w, _, ofs_x, _) in glyphs:
+        if code in DIGITS:
+            digit_cell_w = max(digit_cell_w, adv_px(adv_w), ofs_x + w)
+
+    sprites = []
+    for code, (index, adv_w, w, h, ofs_x, ofs_y) in glyphs:
+        pixels = unpack_pixels(font["bitmap"], index, w * h, font["bpp"])
+        data = bytearray()
+        for px in pixels:
+            data.extend(rgb565(blend(fg, bg, (px * 255 + alpha_max // 2) // alpha_max), swap))
+
+        if code in DIGITS:
+            cell_w = digit_cell_w
+            x = ofs_x + (digit_cell_w - adv_px(adv_w)) // 2
+        else:
+            cell_w = max(adv_px(adv_w), ofs_x + w)
+            x = ofs_x
+        y = top - h - ofs_y
+        sprites.append({"code": code, "cell_w": cell_w, "x": x, "y": y, "w": w, "h": h, "data": bytes(data)})
+    return sprites
+
+
+def c_bytes(data, indent="    "):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append(indent + ", ".join("0x%02x" % b for b in data[i:i + 16]))
+    return ",\n".join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--output", required=True, help="atlas .c file to write")
+    parser.add_argument(
+        "--font",
+        action="append",
+        required=True,
+        metavar="NAME:FONT_C:GLYPHS",
+        help="atlas symbol suffix, lv_font_conv font file and code points",
+    )
+    parser.add_argument("--fg", type=lambda v: int(v, 0), default=0xFFFFFF, help="foreground RGB888")
+    parser.add_argument("--bg", type=lambda v: int(v, 0), default=0x000000, help="background RGB888")
+    parser.add_argument("--swap", action="store_true", help="byte-swap RGB565 (LV_COLOR_16_SWAP)")
+    args = parser.parse_args()
+
+    out = []
+    out.append("/*******************************************************************************")
+    out.append(" * Generated by components/ui/tools/digit_atlas.py - do not edit")
+    out.append(" * Colors: fg 0x%06X on bg 0x%06X, RGB565%s" % (args.fg, args.bg, " swapped" if args.swap else ""))
+    out.append(" ******************************************************************************/")
+    out.append("")
+    out.append('#include "ui_digits.h"')
+
+    for spec in args.font:
+        try:
+            # The path may itself contain ':' (drive letters), the name and glyphs never do.
+            name, rest = spec.split(":", 1)
+            path, glyph_spec = rest.rsplit(":", 1)
+        except ValueError:
+            fail("bad --font spec '%s'" % spec)
+        font = parse_font(path)
+        sprites = build_sprites(font, parse_glyph_list(glyph_spec), args.fg, args.bg, args.swap)
+
+        for sprite in sprites:
+            out.append("")
+            out.append("/* U+%04X */" % sprite["code"])
+            out.append("static const uint8_t %s_%04x_map[] = {" % (name, sprite["code"]))
+            out.append(c_bytes(sprite["data"]))
+            out.append("};")
+
+        out.append("")
+        out.append("static const ui_digit_sprite_t %s_sprites[] = {" % name)
+        for sprite in sprites:
+            out.append("    {")
+            out.append("        .letter = 0x%04x," % sprite["code"])
+            out.append("        .cell_w = %d," % sprite["cell_w"])
+            out.append("        .x = %d," % sprite["x"])
+            out.append("        .y = %d," % sprite["y"])
+            out.append("        .img =")
+            out.append("            {")
+            out.append("                .header.cf = LV_IMG_CF_TRUE_COLOR,")
+            out.append("                .header.always_zero = 0,")
+            out.append("                .header.w = %d," % sprite["w"])
+            out.append("                .header.h = %d," % sprite["h"])
+            out.append("                .data_size = %d," % len(sprite["data"]))
+            out.append("                .data = %s_%04x_map," % (name, sprite["code"]))
+            out.append("            },")
+            out.append("    },")
+        out.append("};")
+        out.append("")
+        out.append("const ui_digit_atlas_t ui_digit_atlas_%s = {" % name)
+        out.append("    .sprites = %s_sprites," % name)
+        out.append("    .sprite_count = %d," % len(sprites))
+        out.append("    .cell_h = %d," % font["line_height"])
+        out.append("};")
+
+        total = sum(len(s["data"]) for s in sprites)
+        print("ui_digit_atlas_%s: %d sprites, %d bytes" % (name, len(sprites), total))
+
+    out.append("")
+    os.makedirs(os.path.dirname(os.path.abspath(args.output)), exist_ok=True)
+    with open(args.output, "w", encoding="utf-8", newline="\n") as f:
+        f.write("\n".join(out))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,443 @@
+#!/usr/bin/env python3
+"""Subset an lv_font_conv generated LVGL font to the glyphs the UI renders.
+
+Reads a font .c file produced by lv_font_conv (uncompressed, no kerning,
+format-0 character maps), keeps only the requested code points, optionally
+re-quantizes the bitmaps to a lower bpp and applies LVGL's RLE glyph
+compression when it makes the bitmap smaller. Prints a one-line flash
+report per font.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+GLYPH_DSC_RE = re.compile(
+    r"\{\.bitmap_index = (\d+), \.adv_w = (\d+), \.box_w = (\d+), \.box_h = (\d+), "
+    r"\.ofs_x = (-?\d+), \.ofs_y = (-?\d+)\}"
+)
+CMAP_RE = re.compile(
+    r"\.range_start = (\d+), \.range_length = (\d+), \.glyph_id_start = (\d+),\s*"
+    r"\.unicode_list = NULL, \.glyph_id_ofs_list = NULL, \.list_length = 0, "
+    r"\.type = LV_FONT_FMT_TXT_CMAP_FORMAT0_TINY"
+)
+
+BITMAP_PLAIN = 0
+BITMAP_COMPRESSED = 1
+BITMAP_COMPRESSED_NO_PREFILTER = 2
+
+RLE_REPEAT_LIMIT = 11
+RLE_COUNTER_MAX = 63
+
+
+class BitWriter:
+    def __init__(self):
+        self.data = bytearray()
+        self.bit_pos = 0
+
+    def write(self, value, length):
+        for shift in range(length - 1, -1, -1):
+            if self.bit_pos % 8 == 0:
+                self.data.append(0)
+            if (value >> shift) & 1:
+                self.data[-1] |= 0x80 >> (self.bit_pos % 8)
+            self.bit_pos += 1
+
+
+class BitReader:
+    def __init__(self, data):
+        self.data = data
+        self.bit_pos = 0
+
+    def read(self, length):
+        value = 0
+        for _ in range(length):
+            byte = self.data[self.bit_pos // 8] if self.bit_pos // 8 < len(self.data) else 0
+            value = (value << 1) | ((byte >> (7 - self.bit_pos % 8)) & 1)
+            self.bit_pos += 1
+        return value
+
+
+def fail(msg):
+    sys.stderr.write("font_subset: %s\n" % msg)
+    sys.exit(1)
+
+
+def parse_int_field(text, name):
+    match = re.search(r"\.%s = (-?\d+)" % name, text)
+    if not match:
+        fail("field .%s not found" % name)
+    return int(match.group(1))
+
+
+def parse_font(path):
+    with open(path, encoding="utf-8") as f:
+        text = f.read()
+
+    bitmap_match = re.search(r"glyph_bitmap\[\] = \{(.*?)\n\};", text, re.S)
+    if not bitmap_match:
+        fail("%s: glyph_bitmap not found" % path)
+    bitmap_body = re.sub(r"/\*.*?\*/", "", bitmap_match.group(1), flags=re.S)
+    bitmap = bytes(int(tok, 16) for tok in re.findall(r"0x[0-9a-fA-F]+", bitmap_body))
+
+    glyphs = [tuple(int(v) for v in m) for m in GLYPH_DSC_RE.findall(text)]
+    cmaps = [tuple(int(v) for v in m) for m in CMAP_RE.findall(text)]
+    if not glyphs or not cmaps:
+        fail("%s: glyph_dsc or cmaps not recognized" % path)
+    if ".kern_dsc = NULL" not in text:
+        fail("%s: kerning is not supported" % path)
+    if parse_int_field(text, "bitmap_format") != BITMAP_PLAIN:
+        fail("%s: input must be uncompressed" % path)
+
+    name_match = re.search(r"lv_font_t (\w+) = \{", text)
+    if not name_match:
+        fail("%s: public font symbol not found" % path)
+
+    return {
+        "name": name_match.group(1),
+        "bitmap": bitmap,
+        "glyphs": glyphs,
+        "cmaps": cmaps,
+        "bpp": parse_int_field(text, "bpp"),
+        "line_height": parse_int_field(text, "line_height"),
+        "base_line": parse_int_field(text, "base_line"),
+        "underline_position": parse_int_field(text, "underline_position"),
+        "underline_thickness": parse_int_field(text, "underline_thickness"),
+    }
+
+
+def parse_glyph_list(spec):
+    codes = set()
+    for part in spec.split(","):
+        part = part.strip()
+        if not part:
+            continue
+        if "-" in part[1:]:
+            lo, hi = part.split("-", 1)
+            codes.update(range(int(lo, 0), int(hi, 0) + 1))
+        else:
+            codes.add(int(part, 0))
+    return sorted(codes)
+
+
+def glyph_id_for(font, code):
+    for range_start, range_length, glyph_id_start in font["cmaps"]:
+        if range_start <= code < range_start + range_length:
+            return glyph_id_start + code - range_start
+    return None
+
+
+def unpack_pixels(data, offset, count, bpp):
+    reader = BitReader(data[offset:offset + (count * bpp + 7) // 8])
+    return [reader.read(bpp) for _ in range(count)]
+
+
+def pack_pixels(pixels, bpp):
+    writer = BitWriter()
+    for px in pixels:
+        writer.write(px, bpp)
+    return bytes(writer.data)
+
+
+def requantize(pixels, src_bpp, dst_bpp):
+    if src_bpp == dst_bpp:
+        return pixels
+    src_max = (1 << src_bpp) - 1
+    dst_max = (1 << dst_bpp) - 1
+    return [(px * dst_max + src_max // 2) // src_max for px in pixels]
+
+
+def rle_encode(values, bpp):
+    """Encode values with the RLE scheme decoded by lv_font_fmt_txt.c (rle_next)."""
+    writer = BitWriter()
+    state = "single"
+    prev = None
+    cnt = 0
+    i = 0
+    while i < len(values):
+        v = values[i]
+        if state == "single":
+            writer.write(v, bpp)
+            if prev is not None and v == prev:
+                state = "repeat"
+                cnt = 0
+            prev = v
+        elif state == "repeat":
+            cnt += 1
+            if v == prev:
+                writer.write(1, 1)
+                if cnt == RLE_REPEAT_LIMIT:
+                    run = 0
+                    while i + 1 + run < len(values) and values[i + 1 + run] == prev:
+                        run += 1
+                    counter = min(run + 1, RLE_COUNTER_MAX)
+                    writer.write(counter, 6)
+                    state = "counter"
+                    cnt = counter
+            else:
+                writer.write(0, 1)
+                writer.write(v, bpp)
+                prev = v
+                state = "single"
+        else:
+            cnt -= 1
+            if cnt == 0:
+                writer.write(v, bpp)
+                prev = v
+                state = "single"
+        i += 1
+    return bytes(writer.data)
+
+
+def rle_decode(data, count, bpp):
+    """Reference decoder mirroring rle_next() in lv_font_fmt_txt.c."""
+    reader = BitReader(data)
+    out = []
+    state = "single"
+    prev = 0
+    cnt = 0
+    for _ in range(count):
+        if state == "single":
+            ret = reader.read(bpp)
+            if reader.bit_pos != bpp and prev == ret:
+                cnt = 0
+                state = "repeat"
+            prev = ret
+        elif state == "repeat":
+            cnt += 1
+            if reader.read(1) == 1:
+                ret = prev
+                if cnt == RLE_REPEAT_LIMIT:
+                    cnt = reader.read(6)
+                    if cnt != 0:
+                        state = "counter"
+                    else:
+                        ret = reader.read(bpp)
+                        prev = ret
+                        state = "single"
+            else:
+                ret = reader.read(bpp)
+                prev = ret
+                state = "single"
+        else:
+            ret = prev
+            cnt -= 1
+            if cnt == 0:
+                ret = reader.read(bpp)
+                prev = ret
+                state = "single"
+        out.append(ret)
+    return out
+
+
+def prefilter(pixels, w, h):
+    out = list(pixels[:w])
+    for y in range(1, h):
+        row = pixels[y * w:(y + 1) * w]
+        above = pixels[(y - 1) * w:y * w]
+        out.extend(a ^ b for a, b in zip(row, above))
+    return out
+
+
+def encode_glyph(pixels, w, h, bpp, bitmap_format):
+    if bitmap_format == BITMAP_PLAIN:
+        return pack_pixels(pixels, bpp)
+    values = prefilter(pixels, w, h) if bitmap_format == BITMAP_COMPRESSED else pixels
+    encoded = rle_encode(values, bpp)
+    decoded = rle_decode(encoded, len(values), bpp)
+    if decoded != values:
+        fail("RLE round-trip mismatch")
+    return encoded
+
+
+def build_subset(font, codes, dst_bpp, allow_compression):
+    selected = []
+    for code in codes:
+        gid = glyph_id_for(font, code)
+        if gid is None:
+            fail("%s: U+%04X is not in the source font" % (font["name"], code))
+        selected.append((code, font["glyphs"][gid]))
+
+    glyph_pixels = []
+    for code, (index, adv_w, w, h, ofs_x, ofs_y) in selected:
+        pixels = unpack_pixels(font["bitmap"], index, w * h, font["bpp"])
+        glyph_pixels.append(requantize(pixels, font["bpp"], dst_bpp))
+
+    formats = [BITMAP_PLAIN]
+    if allow_compression:
+        formats += [BITMAP_COMPRESSED, BITMAP_COMPRESSED_NO_PREFILTER]
+
+    best = None
+    for bitmap_format in formats:
+        chunks = []
+        for (code, dsc), pixels in zip(selected, glyph_pixels):
+            chunks.append(encode_glyph(pixels, dsc[2], dsc[3], dst_bpp, bitmap_format))
+        size = sum(len(c) for c in chunks)
+        if best is None or size < best[1]:
+            best = (bitmap_format, size, chunks)
+
+    return selected, best
+
+
+def c_bytes(data, indent="    "):
+    lines = []
+    for i in range(0, len(data), 8):
+        lines.append(indent + ", ".join("0x%x" % b for b in data[i:i + 8]))
+    return ",\n".join(lines)
+
+
+def char_comment(code):
+    ch = chr(code)
+    if ch == "\\" or ch == '"':
+        ch = "\\" + ch
+    return 'U+%04X "%s"' % (code, ch)
+
+
+def write_font(path, font, source_name, selected, bitmap_format, chunks, bpp):
+    guard = font["name"].upper()
+    format_name = {
+        BITMAP_PLAIN: "plain",
+        BITMAP_COMPRESSED: "compressed, prefilter",
+        BITMAP_COMPRESSED_NO_PREFILTER: "compressed, no prefilter",
+    }[bitmap_format]
+
+    out = []
+    out.append("/*******************************************************************************")
+    out.append(" * Generated by components/ui/tools/font_subset.py - do not edit")
+    out.append(" * Source: %s" % source_name)
+    out.append(" * Bpp: %d (%s)" % (bpp, format_name))
+    out.append(" * Glyphs: %s" % " ".join("U+%04X" % code for code, _ in selected))
+    out.append(" ******************************************************************************/")
+    out.append("")
+    out.append('#include "lvgl.h"')
+    out.append("")
+    out.append("#ifndef %s" % guard)
+    out.append("#define %s 1" % guard)
+    out.append("#endif")
+    out.append("")
+    out.append("#if %s" % guard)
+    out.append("")
+    out.append("static LV_ATTRIBUTE_LARGE_CONST const uint8_t glyph_bitmap[] = {")
+    body = []
+    for (code, _), chunk in zip(selected, chunks):
+        entry = "    /* %s */\n" % char_comment(code)
+        entry += c_bytes(chunk) if chunk else ""
+        body.append(entry)
+    # One pad byte: the RLE reader may peek one byte past the last glyph.
+    body.append("    /* padding */\n    0x0")
+    out.append(",\n\n".join(b.rstrip() for b in body))
+    out.append("};")
+    out.append("")
+    out.append("static const lv_font_fmt_txt_glyph_dsc_t glyph_dsc[] = {")
+    out.append("    {.bitmap_index = 0, .adv_w = 0, .box_w = 0, .box_h = 0, .ofs_x = 0, .ofs_y = 0} /* id = 0 reserved */,")
+    index = 0
+    dsc_lines = []
+    for (code, dsc), chunk in zip(selected, chunks):
+        _, adv_w, w, h, ofs_x, ofs_y = dsc
+        dsc_lines.append(
+            "    {.bitmap_index = %d, .adv_w = %d, .box_w = %d, .box_h = %d, .ofs_x = %d, .ofs_y = %d}"
+            % (index, adv_w, w, h, ofs_x, ofs_y)
+        )
+        index += len(chunk)
+    out.append(",\n".join(dsc_lines))
+    out.append("};")
+    out.append("")
+
+    range_start = selected[0][0]
+    range_length = selected[-1][0] - range_start + 1
+    out.append("static const uint16_t unicode_list_0[] = {")
+    out.append("    " + ", ".join("0x%x" % (code - range_start) for code, _ in selected))
+    out.append("};")
+    out.append("")
+    out.append("static const lv_font_fmt_txt_cmap_t cmaps[] = {")
+    out.append("    {")
+    out.append("        .range_start = %d, .range_length = %d, .glyph_id_start = 1," % (range_start, range_length))
+    out.append(
+        "        .unicode_list = unicode_list_0, .glyph_id_ofs_list = NULL, .list_length = %d, "
+        ".type = LV_FONT_FMT_TXT_CMAP_SPARSE_TINY" % len(selected)
+    )
+    out.append("    }")
+    out.append("};")
+    out.append("")
+    out.append("#if LVGL_VERSION_MAJOR == 8")
+    out.append("static lv_font_fmt_txt_glyph_cache_t cache;")
+    out.append("#endif")
+    out.append("")
+    out.append("static const lv_font_fmt_txt_dsc_t font_dsc = {")
+    out.append("    .glyph_bitmap = glyph_bitmap,")
+    out.append("    .glyph_dsc = glyph_dsc,")
+    out.append("    .cmaps = cmaps,")
+    out.append("    .kern_dsc = NULL,")
+    out.append("    .kern_scale = 0,")
+    out.append("    .cmap_num = 1,")
+    out.append("    .bpp = %d," % bpp)
+    out.append("    .kern_classes = 0,")
+    out.append("    .bitmap_format = %d," % bitmap_format)
+    out.append("#if LVGL_VERSION_MAJOR == 8")
+    out.append("    .cache = &cache")
+    out.append("#endif")
+    out.append("};")
+    out.append("")
+    out.append("const lv_font_t %s = {" % font["name"])
+    out.append("    .get_glyph_dsc = lv_font_get_glyph_dsc_fmt_txt,")
+    out.append("    .get_glyph_bitmap = lv_font_get_bitmap_fmt_txt,")
+    out.append("    .line_height = %d," % font["line_height"])
+    out.append("    .base_line = %d," % font["base_line"])
+    out.append("    .subpx = LV_FONT_SUBPX_NONE,")
+    out.append("    .underline_position = %d," % font["underline_position"])
+    out.append("    .underline_thickness = %d," % font["underline_thickness"])
+    out.append("    .dsc = &font_dsc,")
+    out.append("    .fallback = NULL,")
+    out.append("    .user_data = NULL,")
+    out.append("};")
+    out.append("")
+    out.append("#endif /* %s */" % guard)
+    out.append("")
+
+    os.makedirs(os.path.dirname(os.path.abspath(path)), exist_ok=True)
+    with open(path, "w", encoding="utf-8", newline="\n") as f:
+        f.write("\n".join(out))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--input", required=True, help="lv_font_conv generated font .c file")
+    parser.add_argument("--output", required=True, help="subset font .c file to write")
+    parser.add_argument("--glyphs", required=True, help="code points, e.g. 0x25,0x30-0x39,0xB0")
+    parser.add_argument("--bpp", type=int, choices=(1, 2, 4, 8), help="target bpp (default: keep source bpp)")
+    parser.add_argument("--no-compress", action="store_true", help="never emit RLE-compressed bitmaps")
+    args = parser.parse_args()
+
+    font = parse_font(args.input)
+    bpp = args.bpp or font["bpp"]
+    if bpp > font["bpp"]:
+        fail("%s: cannot raise bpp from %d to %d" % (font["name"], font["bpp"], bpp))
+    if bpp not in (2, 4, 8) and not args.no_compress:
+        args.no_compress = True
+
+    codes = parse_glyph_list(args.glyphs)
+    selected, (bitmap_format, size, chunks) = build_subset(font, codes, bpp, not args.no_compress)
+    write_font(args.output, font, os.path.basename(args.input), selected, bitmap_format, chunks, bpp)
+
+    src_glyphs = len(font["glyphs"]) - 1
+    src_size = len(font["bitmap"]) + len(font["glyphs"]) * 8
+    dst_size = size + 1 + (len(selected) + 1) * 8 + len(selected) * 2
+    print(
+        "%s: %d -> %d glyphs, %d bpp -> %d bpp%s, %d -> %d bytes (saved %d)"
+        % (
+            font["name"],
+            src_glyphs,
+            len(selected),
+            font["bpp"],
+            bpp,
+            ", compressed" if bitmap_format != BITMAP_PLAIN else "",
+            src_size,
+            dst_size,
+            src_size - dst_size,
+        )
+    )
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,106 @@
+# Source lists and generation rules of the ui component, shared by the IDF
+# component (CMakeLists.txt) and the host scenario build (test/host).
+#
+# Inputs: UI_FONT_SUBSET, UI_DIGIT_ATLAS, UI_SCENARIO_RUNNER, UI_FONT_COMPRESSED,
+# UI_COLOR_16_SWAP (booleans), UI_PYTHON and UI_GEN_DIR.
+# Output: UI_SRCS.
+
+set(UI_DIR "${CMAKE_CURRENT_LIST_DIR}")
+
+set(UI_SRCS
+    "${UI_DIR}/src/images.c"
+    "${UI_DIR}/src/screens.c"
+    "${UI_DIR}/src/ui.c"
+    "${UI_DIR}/src/ui_fonts.c"
+    "${UI_DIR}/src/ui_navigation.c"
+    "${UI_DIR}/src/ui_special.c"
+    "${UI_DIR}/src/ui_values.c"
+    "${UI_DIR}/src/ui_font_sf_b_10_digits.c"
+)
+
+# Large fonts are subset to the glyphs the screens render. Keep these lists in
+# sync with the label text in screens.c and ui_values.c.
+set(UI_SUBSET_FONTS
+    "ui_font_sf_sb_30_digits"
+    "ui_font_sf_sb_50_digits"
+    "ui_font_sf_sb_60_digits"
+)
+# Digits, '%', the screen titles "IAQ", "Temp", "Hum" and '-' for negative
+# temperatures on the ambient glance (the source font has no degree sign).
+set(UI_FONT_GLYPHS_ui_font_sf_sb_30_digits "0x25,0x2D,0x30-0x39,0x41,0x48,0x49,0x51,0x54,0x65,0x6D,0x70,0x75")
+# Digits and '%' (humidity at 100 %).
+set(UI_FONT_GLYPHS_ui_font_sf_sb_50_digits "0x25,0x30-0x39")
+# Digits, '%', '-' and degree sign.
+set(UI_FONT_GLYPHS_ui_font_sf_sb_60_digits "0x25,0x2D,0x30-0x39,0xB0")
+
+# Sprites for the big value widgets, blended white on black.
+set(UI_DIGIT_ATLAS_FONTS
+    "sf_sb_60:${UI_DIR}/src/ui_font_sf_sb_60_digits.c:${UI_FONT_GLYPHS_ui_font_sf_sb_60_digits}"
+    "sf_sb_50:${UI_DIR}/src/ui_font_sf_sb_50_digits.c:${UI_FONT_GLYPHS_ui_font_sf_sb_50_digits}"
+)
+set(UI_DIGIT_ATLAS_SRC "${UI_GEN_DIR}/fonts/ui_digit_atlas.c")
+
+if(UI_SCENARIO_RUNNER)
+    list(APPEND UI_SRCS "${UI_DIR}/src/ui_scenarios.c")
+endif()
+
+if(UI_DIGIT_ATLAS)
+    list(APPEND UI_SRCS "${UI_DIR}/src/ui_digits.c" "${UI_DIGIT_ATLAS_SRC}")
+endif()
+
+foreach(font ${UI_SUBSET_FONTS})
+    if(UI_FONT_SUBSET)
+        list(APPEND UI_SRCS "${UI_GEN_DIR}/fonts/${font}.c")
+    else()
+        list(APPEND UI_SRCS "${UI_DIR}/src/${font}.c")
+    endif()
+endforeach()
+
+# Custom commands producing the generated sources; call from the directory
+# that owns the target using them.
+function(ui_add_generated_sources)
+    if(UI_FONT_SUBSET)
+        set(font_subset_args --bpp 4)
+        if(NOT UI_FONT_COMPRESSED)
+            list(APPEND font_subset_args --no-compress)
+        endif()
+
+        foreach(font ${UI_SUBSET_FONTS})
+            add_custom_command(
+                OUTPUT "${UI_GEN_DIR}/fonts/${font}.c"
+                COMMAND ${UI_PYTHON} "${UI_DIR}/tools/font_subset.py"
+                    --input "${UI_DIR}/src/${font}.c"
+                    --output "${UI_GEN_DIR}/fonts/${font}.c"
+                    --glyphs "${UI_FONT_GLYPHS_${font}}"
+                    ${font_subset_args}
+                DEPENDS "${UI_DIR}/src/${font}.c" "${UI_DIR}/tools/font_subset.py"
+                COMMENT "Subsetting ${font}"
+                VERBATIM
+            )
+        endforeach()
+    endif()
+
+    if(UI_DIGIT_ATLAS)
+        set(digit_atlas_args)
+        foreach(spec ${UI_DIGIT_ATLAS_FONTS})
+            list(APPEND digit_atlas_args --font "${spec}")
+        endforeach()
+        if(UI_COLOR_16_SWAP)
+            list(APPEND digit_atlas_args --swap)
+        endif()
+
+        add_custom_command(
+            OUTPUT "${UI_DIGIT_ATLAS_SRC}"
+            COMMAND ${UI_PYTHON} "${UI_DIR}/tools/digit_atlas.py"
+                --output "${UI_DIGIT_ATLAS_SRC}"
+                ${digit_atlas_args}
+            DEPENDS
+                "${UI_DIR}/src/ui_font_sf_sb_50_digits.c"
+                "${UI_DIR}/src/ui_font_sf_sb_60_digits.c"
+                "${UI_DIR}/tools/digit_atlas.py"
+                "${UI_DIR}/tools/font_subset.py"
+            COMMENT "Generating digit atlas"
+            VERBATIM
+        )
+    endif()
+endfunction()
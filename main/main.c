@@ -5,21 +5,38 @@
 #include "backlight.h"
 #include "bme680_sensor.h"
 #include "buttons.h"
+#include "deferred_log.h"
 #include "display.h"
+#include "display_lvgl.h"
 #include "driver/gpio.h"
+#include "esp_attr.h"
 #include "esp_log.h"
 #include "esp_lvgl_port.h"
 #include "esp_system.h"
 #include "esp_pm.h"
-#include "esp_spiffs.h"
+#include "esp_sleep.h"
 #include "esp_timer.h"
+#include "fonts.h"
+#include "images.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 #include "freertos/task.h"
 #include "lvgl.h"
 #include "power_manager.h"
 #include "sdkconfig.h"
+#include "sensor_history.h"
+#if CONFIG_STORAGE_FS_LITTLEFS
+#include "esp_littlefs.h"
+#else
+#include "esp_spiffs.h"
+#endif
 #include "ui.h"
+#if CONFIG_UI_DIGIT_ATLAS
+#include "ui_digits.h"
+#endif
+#if CONFIG_UI_SCENARIO_RUNNER
+#include "ui_scenarios.h"
+#endif
 
 static const char* TAG = "main";
 
@@ -34,6 +51,9 @@ static const char* TAG = "main";
 #define BME680_I2C_ADDR_HIGH 0x77
 #define BME680_HEATER_TEMP_C 300
 #define BME680_HEATER_DUR_MS 100
+/* BSEC sample periods, for the heater share of the battery load model. */
+#define BME680_LP_PERIOD_MS 3000U
+#define BME680_ULP_PERIOD_MS 300000U
 #define IAQ_USABLE_ACCURACY 1U
 
 #define UI_ACTIVE_BRIGHTNESS_PCT 60
@@ -48,9 +68,22 @@ static const char* TAG = "main";
 #define STARTUP_LVGL_LOCK_TIMEOUT_MS 300
 #define STARTUP_LVGL_LOCK_RETRIES 5
 #define STARTUP_LVGL_LOCK_RETRY_DELAY_MS 30
+#define FONT_BENCH_ITERATIONS 200
+#define DIGIT_BENCH_CHANGES 50
+#define MONITORING_SAMPLE_ATTEMPTS 3
+#define RESUME_SNAPSHOT_MAGIC 0x4E494D42U /* "NIMB" */
+#define RESUME_SNAPSHOT_LOCK_MS 50
+#define STORAGE_BASE_PATH "/assets"
+#define STORAGE_PARTITION_LABEL "storage"
+
+#if CONFIG_DISPLAY_BOOT_SPLASH
+extern const uint8_t boot_splash_bin_start[] asm("_binary_img_base_bin_start");
+extern const uint8_t boot_splash_bin_end[] asm("_binary_img_base_bin_end");
+#endif
 
 static backlight_handle_t bl_handle;
 static display_handles_t disp_hw;
+static bool ui_started = false;
 static bool sensor_ready = false;
 static bool sensor_calibration_done = false;
 static bool sensor_ulp_mode = false;
@@ -80,6 +113,7 @@ typedef struct {
 typedef struct {
     bme680_sensor_data_t latest_sensor_data;
     bool has_sensor_data;
+    int64_t sensor_published_us;
     power_battery_info_t battery_info;
     bool monitoring;
     bool charging_transition_pending;
@@ -101,6 +135,7 @@ static sensor_ui_runtime_t sensor_ui_runtime = {
 static sensor_shared_state_t sensor_shared = {
     .latest_sensor_data = {0},
     .has_sensor_data = false,
+    .sensor_published_us = 0,
     .battery_info =
         {
             .percent = -1,
@@ -113,7 +148,25 @@ static sensor_shared_state_t sensor_shared = {
     .charging_now = false,
 };
 
+/*
+ * Last shown state kept in RTC memory over a button-wake deep sleep, so the
+ * wake can put the values on the panel before the sensor and BSEC are back.
+ */
+typedef struct {
+    uint32_t magic;
+    bme680_sensor_data_t sensor_data;
+    bool has_sensor_data;
+    power_battery_info_t battery_info;
+    uint8_t screen;
+    uint8_t brightness_pct;
+} resume_snapshot_t;
+
+static RTC_DATA_ATTR resume_snapshot_t resume_rtc_snapshot;
+static resume_snapshot_t resume_snapshot;
+static bool resume_pending = false;
+
 static iaq_phase_t sensor_iaq_phase = IAQ_PHASE_UNKNOWN;
+static int64_t sensor_ui_last_sample_us = 0;
 static uint16_t sensor_last_logged_iaq = 0xFFFFU;
 static uint8_t sensor_last_logged_accuracy = 0xFFU;
 static bool sensor_last_logged_stabilization_done = false;
@@ -158,6 +211,10 @@ static void sensor_step_battery(
 
     power_battery_info_t sampled_battery = {0};
     esp_err_t battery_ret = power_manager_read_battery(&sampled_battery);
+    if (battery_ret == ESP_ERR_NOT_FINISHED) {
+        /* Burst still sampling; picked up on the next loop. */
+        return;
+    }
     if (battery_ret == ESP_OK && sampled_battery.valid) {
         if (state->battery_info.valid) {
             if (state->battery_info.charging != sampled_battery.charging) {
@@ -170,7 +227,7 @@ static void sensor_step_battery(
         }
 
         if (state->battery_info.charging != sampled_battery.charging) {
-            ESP_LOGI(TAG,
+            DLOG_I(TAG,
                 "Battery state: %s (%u mV, %d%%)",
                 sampled_battery.charging ? "charging" : "battery",
                 (unsigned int)sampled_battery.voltage_mv,
@@ -184,7 +241,7 @@ static void sensor_step_battery(
 
     if (battery_ret == ESP_OK && !sampled_battery.valid) {
         if (state->battery_info.valid) {
-            ESP_LOGW(TAG, "Battery state unavailable (%u mV)", (unsigned int)sampled_battery.voltage_mv);
+            DLOG_W(TAG, "Battery state unavailable (%u mV)", (unsigned int)sampled_battery.voltage_mv);
         }
         state->battery_info = sampled_battery;
         state->last_battery_update_us = now_us;
@@ -201,6 +258,12 @@ static void sensor_step_battery(
     state->last_battery_update_us = now_us;
 }
 
+static void sensor_report_heater_duty(void)
+{
+    uint32_t period_ms = sensor_ulp_mode ? BME680_ULP_PERIOD_MS : BME680_LP_PERIOD_MS;
+    power_manager_set_heater_duty((uint16_t)((BME680_HEATER_DUR_MS * 1000U) / period_ms));
+}
+
 static sensor_sample_result_t sensor_step_read(sensor_worker_state_t* state, bool monitoring)
 {
     sensor_sample_result_t result = {0};
@@ -208,12 +271,21 @@ static sensor_sample_result_t sensor_step_read(sensor_worker_state_t* state, boo
         return result;
     }
 
+#if CONFIG_PM_AMBIENT_MODE
+    /* The glance updates once a minute at most, so sample at the ultra-low-power rate meanwhile. */
+    bool want_ulp_mode = monitoring;
+#elif CONFIG_PM_DEEP_SLEEP_MONITORING
+    /* Nothing is shown while monitoring; the ULP rate is what makes deep sleep between samples pay off. */
+    bool want_ulp_mode = monitoring;
+#else
     (void)monitoring;
     bool want_ulp_mode = false;
+#endif
     if (want_ulp_mode != sensor_ulp_mode) {
         esp_err_t mode_ret = bme680_sensor_set_mode(want_ulp_mode ? BME680_SENSOR_MODE_ULP : BME680_SENSOR_MODE_LP);
         if (mode_ret == ESP_OK) {
             sensor_ulp_mode = want_ulp_mode;
+            sensor_report_heater_duty();
         } else {
             ESP_LOGW(TAG, "BME680 mode switch failed (%s)", esp_err_to_name(mode_ret));
         }
@@ -335,7 +407,7 @@ static void sensor_log_iaq_snapshot(const bme680_sensor_data_t* data)
         return;
     }
 
-    ESP_LOGI(TAG,
+    DLOG_I(TAG,
         "IAQ=%u STATIC_IAQ=%u phase=%s acc=%u valid=%s stab=%s run_in=%s mode=%s",
         (unsigned int)data->iaq,
         (unsigned int)data->static_iaq,
@@ -395,15 +467,26 @@ static void dispatch_button_events(void)
 {
     button_event_msg_t event = {0};
     while (buttons_get_event(&event)) {
-        ESP_LOGI(TAG,
+        DLOG_I(TAG,
             "Button event: %s (%s)",
             (event.button_id == BTN_ID_PREV) ? "PREV" : ((event.button_id == BTN_ID_NEXT) ? "NEXT" : "UNKNOWN"),
             event.is_long_press ? "long" : "short");
+#if CONFIG_DISPLAY_LATENCY_TRACE
+        /* Hold the (recursive) LVGL lock across the handler so the trace sees its invalidations. */
+        int64_t dequeued_us = esp_timer_get_time();
+        bool traced = lvgl_port_lock(100);
+#endif
         if (event.is_long_press) {
             app_on_button_long_press(event.button_id);
         } else {
             app_on_button_short_press(event.button_id);
         }
+#if CONFIG_DISPLAY_LATENCY_TRACE
+        if (traced) {
+            display_lvgl_trace_latency(DISPLAY_LATENCY_PRESS, event.timestamp_us, dequeued_us);
+            lvgl_port_unlock();
+        }
+#endif
     }
 }
 
@@ -427,12 +510,21 @@ static void sensor_task(void* arg)
     bme680_sensor_data_t latest_sensor_data = {0};
     bool has_sensor_data = false;
     int64_t next_sensor_read_us = 0;
+#if CONFIG_DISPLAY_LATENCY_TRACE
+    bool was_monitoring = false;
+#endif
     while (1) {
         dispatch_button_events();
         app_process_idle();
 
         bool monitoring = power_manager_is_monitoring();
         int64_t now = esp_timer_get_time();
+#if CONFIG_DISPLAY_LATENCY_TRACE
+        if (monitoring && !was_monitoring) {
+            display_lvgl_log_latency(false);
+        }
+        was_monitoring = monitoring;
+#endif
 
         bool charging_transition = false;
         bool charging_now = false;
@@ -450,7 +542,13 @@ static void sensor_task(void* arg)
             if (sample.has_sensor_data) {
                 latest_sensor_data = sample.data;
                 has_sensor_data = true;
+                sensor_history_add(&latest_sensor_data);
                 sensor_log_iaq_snapshot(&latest_sensor_data);
+#if CONFIG_PM_DEEP_SLEEP_MONITORING
+                if (monitoring && sensor_ulp_mode) {
+                    power_manager_enter_deep_monitoring(bme680_sensor_get_next_call_us());
+                }
+#endif
             }
 
             uint32_t next_period_ms = (sample.next_period_ms > 0U) ? sample.next_period_ms : SENSOR_DEFAULT_READ_PERIOD_MS;
@@ -458,6 +556,9 @@ static void sensor_task(void* arg)
         }
 
         if (sensor_shared_mutex && xSemaphoreTake(sensor_shared_mutex, pdMS_TO_TICKS(25)) == pdTRUE) {
+            if (latest_sensor_data.timestamp_us != sensor_shared.latest_sensor_data.timestamp_us) {
+                sensor_shared.sensor_published_us = esp_timer_get_time();
+            }
             sensor_shared.latest_sensor_data = latest_sensor_data;
             sensor_shared.has_sensor_data = has_sensor_data;
             sensor_shared.battery_info = worker_state.battery_info;
@@ -473,10 +574,8 @@ static void sensor_task(void* arg)
     }
 }
 
-static void sensor_ui_timer_cb(lv_timer_t* t)
+static void sensor_ui_apply_snapshot(bool force)
 {
-    (void)t;
-
     sensor_shared_state_t snapshot = {0};
     snapshot.battery_info.percent = -1;
     snapshot.battery_info.valid = false;
@@ -496,7 +595,7 @@ static void sensor_ui_timer_cb(lv_timer_t* t)
     }
     xSemaphoreGive(sensor_shared_mutex);
 
-    if (snapshot.monitoring) {
+    if (snapshot.monitoring && !force) {
         return;
     }
 
@@ -505,30 +604,221 @@ static void sensor_ui_timer_cb(lv_timer_t* t)
         sensor_step_charging_overlay(snapshot.charging_transition_pending, snapshot.charging_now, now);
         sensor_step_update_sensor_ui(&snapshot.latest_sensor_data, snapshot.has_sensor_data);
         sensor_step_update_battery_ui(&snapshot.battery_info);
+        if (snapshot.has_sensor_data) {
+            ui_set_values_stale(false);
+        }
+        if (snapshot.has_sensor_data && snapshot.latest_sensor_data.timestamp_us != sensor_ui_last_sample_us) {
+            sensor_ui_last_sample_us = snapshot.latest_sensor_data.timestamp_us;
+            display_lvgl_trace_latency(
+                DISPLAY_LATENCY_SAMPLE, snapshot.latest_sensor_data.timestamp_us, snapshot.sensor_published_us);
+        }
         lvgl_port_unlock();
     }
 }
 
-static bool mount_spiffs(void)
+static void sensor_ui_timer_cb(lv_timer_t* t)
+{
+    (void)t;
+    sensor_ui_apply_snapshot(false);
+}
+
+/* The shared monitoring flag lags the actual wake by up to one sensor loop, so apply regardless. */
+static void sensor_ui_on_display_refresh(void)
+{
+    sensor_ui_apply_snapshot(true);
+}
+
+static void resume_snapshot_save(void)
+{
+    resume_rtc_snapshot.magic = 0;
+    if (!sensor_shared_mutex ||
+        xSemaphoreTake(sensor_shared_mutex, pdMS_TO_TICKS(RESUME_SNAPSHOT_LOCK_MS)) != pdTRUE) {
+        ESP_LOGW(TAG, "Resume snapshot skipped: shared state busy");
+        return;
+    }
+    resume_rtc_snapshot.sensor_data = sensor_shared.latest_sensor_data;
+    resume_rtc_snapshot.has_sensor_data = sensor_shared.has_sensor_data;
+    resume_rtc_snapshot.battery_info = sensor_shared.battery_info;
+    xSemaphoreGive(sensor_shared_mutex);
+
+    resume_rtc_snapshot.screen = (uint8_t)ui_get_data_screen();
+    resume_rtc_snapshot.brightness_pct = power_manager_get_active_brightness();
+    resume_rtc_snapshot.magic = RESUME_SNAPSHOT_MAGIC;
+}
+
+static void prepare_deep_sleep(void)
+{
+    resume_snapshot_save();
+    /* The formatter task does not run again; print what is still queued. */
+    deferred_log_flush();
+}
+
+/* One-shot: a snapshot is only good for the wake right after the sleep that stored it. */
+static bool resume_snapshot_take(void)
+{
+    bool valid = (resume_rtc_snapshot.magic == RESUME_SNAPSHOT_MAGIC) &&
+                 (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_EXT0);
+    if (valid) {
+        resume_snapshot = resume_rtc_snapshot;
+    }
+    resume_rtc_snapshot.magic = 0;
+    return valid;
+}
+
+static void resume_show_snapshot(void)
 {
+    ui_init_at((enum ScreensEnum)resume_snapshot.screen);
+    ui_set_values_stale(true);
+    sensor_step_update_sensor_ui(&resume_snapshot.sensor_data, resume_snapshot.has_sensor_data);
+    sensor_step_update_battery_ui(&resume_snapshot.battery_info);
+    display_lvgl_render_now();
+    backlight_set_brightness(&bl_handle, resume_snapshot.brightness_pct);
+
+    /* The wake is the reset, so boot time is the wake-to-first-value latency. */
+    ESP_LOGI(TAG,
+        "Resumed from deep sleep: last values on panel %lu ms after wake (%s)",
+        (unsigned long)(esp_timer_get_time() / 1000),
+        resume_snapshot.has_sensor_data ? "stale until the first sample" : "no sensor data yet");
+}
+
+#if CONFIG_STORAGE_FS_BENCHMARK
+static void log_storage_benchmark(void)
+{
+    static const char* const paths[] = {
+        IMG_BASE,
+        IMG_ULTRA_HAPPY,
+        IMG_HAPPY,
+        IMG_ORDINARY,
+        IMG_SAD,
+        IMG_DIZZY,
+        IMG_DEAD,
+        IMG_TEMP_MINUS,
+        IMG_TEMP_NORMAL,
+        IMG_TEMP_PLUS,
+        IMG_DIVER,
+        IMG_CAT_HUH,
+        IMG_ORDINARY_NIMBUS,
+        IMG_HAPPY_CLOSED_EYES,
+        IMG_BAD,
+        IMG_CRIT,
+        IMG_WARN,
+        IMG_DAMP,
+        IMG_DRY,
+        IMG_MID,
+        IMG_GOOD,
+        IMG_MINUS,
+        IMG_NOTHING,
+        IMG_PLUS,
+        IMG_BATT_FULL_NOT_CHARGING,
+        IMG_BATT_3_NOT_CHARGING,
+        IMG_BATT_2_NOT_CHARGING,
+        IMG_BATT_1_NOT_CHARGING,
+        IMG_BATT_FULL_CHARGING,
+        IMG_BATT_3_CHARGING,
+        IMG_BATT_2_CHARGING,
+        IMG_BATT_1_CHARGING,
+        IMG_CHARGING,
+        IMG_SUN,
+    };
+    static uint8_t buf[1024];
+    uint32_t total_open_us = 0;
+    uint32_t total_read_us = 0;
+    uint32_t total_bytes = 0;
+    size_t files = 0;
+
+    for (size_t i = 0; i < sizeof(paths) / sizeof(paths[0]); i++) {
+        /* Skip the LVGL drive letter ("S:") to get the VFS path. */
+        const char* path = paths[i] + 2;
+        int64_t start_us = esp_timer_get_time();
+        FILE* f = fopen(path, "rb");
+        int64_t open_us = esp_timer_get_time() - start_us;
+        if (!f) {
+            ESP_LOGW(TAG, "storage bench: %s not found", path);
+            continue;
+        }
+
+        uint32_t bytes = 0;
+        size_t n;
+        start_us = esp_timer_get_time();
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+            bytes += (uint32_t)n;
+        }
+        int64_t read_us = esp_timer_get_time() - start_us;
+        fclose(f);
+
+        ESP_LOGI(TAG,
+            "storage bench %s: open %lu us, read %lu B in %lu us",
+            path,
+            (unsigned long)open_us,
+            (unsigned long)bytes,
+            (unsigned long)read_us);
+        total_open_us += (uint32_t)open_us;
+        total_read_us += (uint32_t)read_us;
+        total_bytes += bytes;
+        files++;
+    }
+
+    if (files > 0U) {
+        ESP_LOGI(TAG,
+            "storage bench: %u files, open %lu us avg, read %lu B in %lu us total",
+            (unsigned int)files,
+            (unsigned long)(total_open_us / files),
+            (unsigned long)total_bytes,
+            (unsigned long)total_read_us);
+    }
+}
+#endif
+
+/*
+ * The partition only holds the images flashed from assets/, so a mount failure
+ * is not fixed by formatting: that would take seconds and leave it empty.
+ */
+static bool mount_storage(void)
+{
+    int64_t start_us = esp_timer_get_time();
+#if CONFIG_STORAGE_FS_LITTLEFS
+    const char* fs_name = "LittleFS";
+    esp_vfs_littlefs_conf_t conf = {
+        .base_path = STORAGE_BASE_PATH,
+        .partition_label = STORAGE_PARTITION_LABEL,
+        .format_if_mount_failed = false,
+        .read_only = true,
+    };
+    esp_err_t ret = esp_vfs_littlefs_register(&conf);
+#else
+    const char* fs_name = "SPIFFS";
     esp_vfs_spiffs_conf_t conf = {
-        .base_path = "/spiffs",
-        .partition_label = "storage",
+        .base_path = STORAGE_BASE_PATH,
+        .partition_label = STORAGE_PARTITION_LABEL,
         .max_files = 5,
-        .format_if_mount_failed = true,
+        .format_if_mount_failed = false,
     };
-
     esp_err_t ret = esp_vfs_spiffs_register(&conf);
+#endif
+    int64_t mount_us = esp_timer_get_time() - start_us;
+
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "SPIFFS mount failed: %s", esp_err_to_name(ret));
+        ESP_LOGE(TAG, "%s mount failed: %s", fs_name, esp_err_to_name(ret));
         return false;
     }
 
     size_t total = 0, used = 0;
-    ret = esp_spiffs_info(conf.partition_label, &total, &used);
+#if CONFIG_STORAGE_FS_LITTLEFS
+    ret = esp_littlefs_info(STORAGE_PARTITION_LABEL, &total, &used);
+#else
+    ret = esp_spiffs_info(STORAGE_PARTITION_LABEL, &total, &used);
+#endif
     if (ret == ESP_OK) {
-        ESP_LOGI(TAG, "SPIFFS: total=%d, used=%d", total, used);
+        ESP_LOGI(TAG,
+            "%s mounted in %lu us: total=%d, used=%d",
+            fs_name,
+            (unsigned long)mount_us,
+            total,
+            used);
     }
+#if CONFIG_STORAGE_FS_BENCHMARK
+    log_storage_benchmark();
+#endif
 
     return true;
 }
@@ -543,37 +833,252 @@ static void init_lvgl(void)
     };
     ESP_ERROR_CHECK(lvgl_port_init(&lvgl_cfg));
 
-    const lvgl_port_display_cfg_t disp_cfg = {
-        .io_handle = disp_hw.io_handle,
-        .panel_handle = disp_hw.panel_handle,
-        .buffer_size = WIDTH * HEIGHT / 10,
-        .double_buffer = true,
-        .hres = WIDTH,
-        .vres = HEIGHT,
-        .monochrome = false,
-        .rotation =
-            {
-                .swap_xy = false,
-                .mirror_x = false,
-                .mirror_y = false,
-            },
-        .flags =
-            {
-                .buff_dma = true,
-                .buff_spiram = false,
-                .full_refresh = false,
-            },
+    if (!display_lvgl_add(&disp_hw)) {
+        ESP_LOGE(TAG, "Failed to register display with LVGL");
+    }
+}
+
+#if CONFIG_UI_FONT_BENCHMARK
+static void log_font_benchmark(void)
+{
+    static const struct {
+        const char* name;
+        const lv_font_t* font;
+        const char* text;
+    } fonts[] = {
+        {"sf_sb_60", &ui_font_sf_sb_60_digits, "0123456789-%\xC2\xB0"},
+        {"sf_sb_50", &ui_font_sf_sb_50_digits, "0123456789%"},
+        {"sf_sb_30", &ui_font_sf_sb_30_digits, "0123456789%IAQTempHum"},
+        {"sf_b_10", &ui_font_sf_b_10_digits, "0123456789%"},
     };
 
-    lvgl_port_add_disp(&disp_cfg);
+    for (size_t i = 0; i < sizeof(fonts) / sizeof(fonts[0]); i++) {
+        const lv_font_fmt_txt_dsc_t* dsc = (const lv_font_fmt_txt_dsc_t*)fonts[i].font->dsc;
+        ESP_LOGI(TAG,
+            "font %s (%u bpp, %s): %lu ns/glyph",
+            fonts[i].name,
+            (unsigned int)dsc->bpp,
+            dsc->bitmap_format ? "compressed" : "plain",
+            (unsigned long)ui_font_measure_glyph_ns(fonts[i].font, fonts[i].text, FONT_BENCH_ITERATIONS));
+    }
+}
+#endif
+
+#if CONFIG_UI_DIGIT_BENCHMARK
+static void reset_render_stats(void)
+{
+    display_lvgl_stats_t stats;
+    display_lvgl_get_stats(&stats, true);
+}
+
+static void log_digit_benchmark(void)
+{
+    static const struct {
+        const char* name;
+        bool use_atlas;
+    } variants[] = {
+        {"label", false},
+        {"atlas", true},
+    };
+
+    for (size_t i = 0; i < sizeof(variants) / sizeof(variants[0]); i++) {
+        uint32_t total_us = ui_digits_measure_redraw_us(
+            variants[i].use_atlas, DIGIT_BENCH_CHANGES, display_lvgl_render_now, reset_render_stats);
+
+        display_lvgl_stats_t stats = {0};
+        display_lvgl_get_stats(&stats, true);
+
+        ESP_LOGI(TAG,
+            "value redraw %s: %.2f ms/change, render %.2f ms/frame, %lu px/change",
+            variants[i].name,
+            (double)total_us / DIGIT_BENCH_CHANGES / 1000.0,
+            stats.frames ? (double)stats.refresh_us / (double)stats.frames / 1000.0 : 0.0,
+            (unsigned long)(stats.flushed_px / DIGIT_BENCH_CHANGES));
+    }
+}
+#endif
+
+#if CONFIG_UI_SCENARIO_RUNNER
+/* Scenarios without a golden CRC in the last run; ui_scenarios_run() counts them as failed too. */
+static uint32_t scenario_unrecorded = 0;
+
+static void log_scenario_result(const ui_scenario_result_t* result)
+{
+    const char* verdict = "NO GOLDEN";
+    if (result->frame == NULL) {
+        verdict = "NO SNAPSHOT";
+    } else if (result->golden_crc != 0U) {
+        verdict = (result->crc == result->golden_crc) ? "ok" : "MISMATCH";
+    } else {
+        scenario_unrecorded++;
+    }
+
+    ESP_LOGI(TAG,
+        "scenario %s: render=%lu ms frames=%lu dirty=%lu px crc=0x%08lx (%s)",
+        result->name,
+        (unsigned long)result->render_ms,
+        (unsigned long)result->frames,
+        (unsigned long)result->dirty_px,
+        (unsigned long)result->crc,
+        verdict);
+}
+#endif
+
+#if CONFIG_DISPLAY_BOOT_SPLASH
+static void show_boot_splash(void)
+{
+    /* Same spot as the logo on the start screen, so LVGL takes over without a jump. */
+    esp_err_t ret = display_draw_splash(&disp_hw,
+        boot_splash_bin_start,
+        (size_t)(boot_splash_bin_end - boot_splash_bin_start),
+        IMG_INFO_BASE_CENTER.x,
+        IMG_INFO_BASE_CENTER.y);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Boot splash skipped: %s", esp_err_to_name(ret));
+    }
+}
+#endif
+
+static esp_err_t init_sensor(void)
+{
+    bme680_sensor_config_t bme_cfg = {
+        .i2c_port = BME680_I2C_PORT,
+        .sda_io_num = BME680_I2C_SDA_GPIO,
+        .scl_io_num = BME680_I2C_SCL_GPIO,
+        .i2c_clk_speed_hz = BME680_I2C_SPEED_HZ,
+        .i2c_addr = BME680_I2C_ADDR_LOW,
+        .heater_temp_c = BME680_HEATER_TEMP_C,
+        .heater_dur_ms = BME680_HEATER_DUR_MS,
+        .disable_state_persistence = false,
+        .reset_baseline_on_power_on = false,
+    };
+
+    esp_err_t ret = bme680_sensor_init(&bme_cfg);
+    if (ret != ESP_OK) {
+        bme_cfg.i2c_addr = BME680_I2C_ADDR_HIGH;
+        ESP_LOGW(TAG, "BME680 not found at 0x%02X, trying 0x%02X", BME680_I2C_ADDR_LOW, BME680_I2C_ADDR_HIGH);
+        ret = bme680_sensor_init(&bme_cfg);
+    }
+
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "BME680 initialized at I2C address 0x%02X", bme_cfg.i2c_addr);
+    }
+    return ret;
+}
+
+#if CONFIG_PM_DEEP_SLEEP_MONITORING
+/*
+ * Timer wake from deep monitoring: sensor only, no display, LVGL or asset filesystem.
+ * Takes the one sample BSEC is waiting for and sleeps again; does not return
+ * unless the sensor is gone, in which case the normal boot shows the error.
+ */
+static void run_monitoring_sample(void)
+{
+    if (init_sensor() != ESP_OK) {
+        ESP_LOGE(TAG, "BME680 init failed on monitoring wake, starting the UI");
+        return;
+    }
+
+    bme680_sensor_data_t data = {0};
+    for (int attempt = 0; attempt < MONITORING_SAMPLE_ATTEMPTS; attempt++) {
+        if (bme680_sensor_read(&data) != ESP_OK) {
+            break;
+        }
+        if (data.timestamp_us != 0) {
+            ESP_LOGI(TAG,
+                "Monitoring sample: IAQ=%u (acc=%u), T=%.2f C, RH=%.1f %%, %lld ms after wake",
+                (unsigned int)data.iaq,
+                (unsigned int)data.iaq_accuracy,
+                (double)data.temperature_c,
+                (double)data.humidity_rh,
+                (long long)(esp_timer_get_time() / 1000));
+            if (resume_rtc_snapshot.magic == RESUME_SNAPSHOT_MAGIC) {
+                resume_rtc_snapshot.sensor_data = data;
+                resume_rtc_snapshot.has_sensor_data = true;
+            }
+            /* Only the RTC tiers take it; the minute ring is not allocated on this path. */
+            sensor_history_add(&data);
+            break;
+        }
+        /* Woke a little before BSEC's next call; wait it out. */
+        vTaskDelay(pdMS_TO_TICKS(bme680_sensor_get_next_call_us() / 1000ULL + 1U));
+    }
+
+    power_manager_enter_deep_monitoring(bme680_sensor_get_next_call_us());
+}
+#endif
+
+static bool start_ui(void)
+{
+    ESP_LOGI(TAG, "Init LVGL...");
+    init_lvgl();
+    ui_started = true;
+
+    ESP_LOGI(TAG, "Init UI...");
+    if (!lvgl_port_lock(100)) {
+        ESP_LOGE(TAG, "Failed to lock LVGL for initial UI setup");
+        return false;
+    }
+
+    if (resume_pending) {
+        resume_show_snapshot();
+        lvgl_port_unlock();
+        return true;
+    }
+
+    ui_init();
+#if CONFIG_UI_FONT_BENCHMARK
+    log_font_benchmark();
+#endif
+#if CONFIG_UI_DIGIT_BENCHMARK
+    log_digit_benchmark();
+#endif
+#if CONFIG_UI_SCENARIO_RUNNER
+    scenario_unrecorded = 0;
+    uint32_t scenario_failed = ui_scenarios_run(log_scenario_result);
+    if (scenario_failed > scenario_unrecorded) {
+        ESP_LOGW(TAG,
+            "%lu UI scenario(s) failed against golden frames",
+            (unsigned long)(scenario_failed - scenario_unrecorded));
+    }
+    if (scenario_unrecorded > 0U) {
+        ESP_LOGI(TAG,
+            "%lu UI scenario(s) have no golden CRC yet; record them with components/ui/test/host",
+            (unsigned long)scenario_unrecorded);
+    }
+#endif
+#if !CONFIG_DISPLAY_BOOT_SPLASH
+    display_lvgl_render_now();
+    ESP_LOGI(TAG, "First frame (LVGL) on panel %lu ms after boot", (unsigned long)(esp_timer_get_time() / 1000));
+#endif
+    lvgl_port_unlock();
+    return true;
 }
 
 void app_main(void)
 {
     bool startup_has_non_critical_error = false;
 
+#if CONFIG_PM_DEEP_SLEEP_MONITORING
+    if (power_manager_is_deep_monitoring_wake()) {
+        run_monitoring_sample();
+    }
+#endif
+    resume_pending = resume_snapshot_take();
+    if (deferred_log_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Deferred log task not started; DLOG lines only print on flush");
+    }
+
     ESP_LOGI(TAG, "Init Display...");
     disp_hw = display_init();
+#if CONFIG_DISPLAY_FLUSH_BENCHMARK
+    display_run_flush_benchmark(&disp_hw);
+#endif
+#if CONFIG_DISPLAY_BOOT_SPLASH
+    if (!resume_pending) {
+        show_boot_splash();
+    }
+#endif
 
     ESP_LOGI(TAG, "Init Backlight...");
     backlight_config_t bl_config = {
@@ -585,66 +1090,76 @@ void app_main(void)
         .freq_hz = 5000,
     };
     ESP_ERROR_CHECK(backlight_init(&bl_config, &bl_handle));
-    ESP_ERROR_CHECK(backlight_set_brightness(&bl_handle, UI_ACTIVE_BRIGHTNESS_PCT));
+    /* On resume the backlight stays off until the snapshot frame is on the panel. */
+    ESP_ERROR_CHECK(backlight_set_brightness(&bl_handle, resume_pending ? 0 : UI_ACTIVE_BRIGHTNESS_PCT));
+#if CONFIG_DISPLAY_BOOT_SPLASH
+    ESP_LOGI(TAG, "First pixel (splash) lit %lu ms after boot", (unsigned long)(esp_timer_get_time() / 1000));
+#endif
 
     ESP_LOGI(TAG, "Init power management...");
     init_power_management();
 
-    ESP_LOGI(TAG, "Mount SPIFFS...");
-    if (!mount_spiffs()) {
+    ESP_LOGI(TAG, "Mount storage...");
+    if (!mount_storage()) {
         startup_has_non_critical_error = true;
     }
 
-    ESP_LOGI(TAG, "Init LVGL...");
-    init_lvgl();
-
-    ESP_LOGI(TAG, "Init UI...");
-    if (lvgl_port_lock(100)) {
-        ui_init();
-        lvgl_port_unlock();
-    } else {
+#if CONFIG_DISPLAY_BOOT_SPLASH
+    bool ui_first = resume_pending;
+#else
+    bool ui_first = true;
+#endif
+    if (ui_first && !start_ui()) {
         startup_has_non_critical_error = true;
-        ESP_LOGE(TAG, "Failed to lock LVGL for initial UI setup");
+    }
+    if (resume_pending) {
+        /* Battery status from the snapshot until the sensor task has a fresh reading. */
+        sensor_shared.battery_info = resume_snapshot.battery_info;
     }
 
     if (startup_has_non_critical_error) {
         goto degraded_startup;
     }
 
-    ESP_LOGI(TAG, "Init BME680...");
-    bme680_sensor_config_t bme_cfg = {
-        .i2c_port = BME680_I2C_PORT,
-        .sda_io_num = BME680_I2C_SDA_GPIO,
-        .scl_io_num = BME680_I2C_SCL_GPIO,
-        .i2c_clk_speed_hz = BME680_I2C_SPEED_HZ,
-        .i2c_addr = BME680_I2C_ADDR_LOW,
-        .heater_temp_c = BME680_HEATER_TEMP_C,
-        .heater_dur_ms = BME680_HEATER_DUR_MS,
-        .disable_state_persistence = false,
-        .reset_baseline_on_power_on = false,
-    };
-
-    esp_err_t sensor_init_ret = bme680_sensor_init(&bme_cfg);
-    if (sensor_init_ret != ESP_OK) {
-        bme_cfg.i2c_addr = BME680_I2C_ADDR_HIGH;
-        ESP_LOGW(TAG, "BME680 not found at 0x%02X, trying 0x%02X", BME680_I2C_ADDR_LOW, BME680_I2C_ADDR_HIGH);
-        sensor_init_ret = bme680_sensor_init(&bme_cfg);
-    }
+    int64_t bringup_start_us = esp_timer_get_time();
+    display_lvgl_stats_t bringup_stats;
+    display_lvgl_get_stats(&bringup_stats, true);
 
-    if (sensor_init_ret == ESP_OK) {
+    ESP_LOGI(TAG, "Init BME680...");
+    if (init_sensor() == ESP_OK) {
         sensor_ready = true;
         sensor_calibration_done = false;
         sensor_ulp_mode = false;
+        sensor_report_heater_duty();
         sensor_iaq_phase = IAQ_PHASE_UNKNOWN;
-        ESP_LOGI(TAG, "BME680 initialized at I2C address 0x%02X", bme_cfg.i2c_addr);
     } else {
         ESP_LOGE(TAG, "BME680 init failed");
     }
 
+    /* Render cost of the start screen spinner over bring-up; zero with the splash, as LVGL is not running yet. */
+    display_lvgl_get_stats(&bringup_stats, true);
+    ESP_LOGI(TAG,
+        "Sensor bring-up took %lu ms, boot animation: %lu frames, %lu ms render",
+        (unsigned long)((esp_timer_get_time() - bringup_start_us) / 1000),
+        (unsigned long)bringup_stats.frames,
+        (unsigned long)(bringup_stats.refresh_us / 1000U));
+
+    if (!ui_started && !start_ui()) {
+        startup_has_non_critical_error = true;
+        goto degraded_startup;
+    }
+
+    /* After the LVGL draw buffers: without PSRAM the minute ring comes out of the same internal RAM. */
+    if (sensor_ready && sensor_history_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Sensor history keeps the 15-minute and daily tiers only");
+    }
+
     ESP_LOGI(TAG, "Init app...");
     app_config_t app_cfg = {
         .display = &disp_hw,
         .backlight = &bl_handle,
+        .on_display_refresh = sensor_ui_on_display_refresh,
+        .on_deep_sleep = prepare_deep_sleep,
     };
     app_init(&app_cfg);
 
@@ -715,6 +1230,9 @@ void app_main(void)
 
 degraded_startup:
     ESP_LOGE(TAG, "Startup degraded: rebooting in 10 seconds");
+    if (!ui_started) {
+        start_ui();
+    }
     if (lvgl_port_lock(100)) {
         ui_finish_startup(true);
         lvgl_port_unlock();